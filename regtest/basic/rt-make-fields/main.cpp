@@ -0,0 +1,70 @@
+#include "plumed/tools/File.h"
+#include "plumed/tools/Tools.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace PLMD;
+
+int main(){
+  std::ofstream oo("output");
+
+// fields written and read back, also compressed
+  for(const std::string name : {"fields","fields.gz"}) {
+    OFile out;
+    out.open(name);
+    out.addConstantField("c");
+    for(int i=0;i<5;i++) {
+      out.printField("c",(i<3?"first":"second"));
+      out.printField("x",0.5*i).printField("n",i);
+      if(i==4) out.printField("extra"," end");
+      out.printField();
+    }
+    out.close();
+
+    IFile in;
+    in.open(name);
+    double x; int n; std::string c,extra;
+    while(in.scanField("x",x)) {
+      in.scanField("n",n).scanField("c",c);
+      if(in.FieldExist("extra")) in.scanField("extra",extra);
+      in.scanField();
+      oo<<name<<" "<<x<<" "<<n<<" "<<c<<" "<<extra<<"\n";
+    }
+    in.close();
+  }
+
+// dos new lines, comments, blank lines, a long line and no new line at the end
+  std::string longword(3000,'a');
+  FILE* fp=std::fopen("input","w");
+  std::fprintf(fp,"#! FIELDS a b c\r\n");
+  std::fprintf(fp,"  1.5\t-2   pi # a comment\r\n");
+  std::fprintf(fp,"\n# only a comment\n");
+  std::fprintf(fp,"1e-3 +7 %s\n",longword.c_str());
+  std::fprintf(fp,"#! SET d 3\n");
+  std::fprintf(fp,"2 3 2*pi#comment");
+  std::fclose(fp);
+  IFile in;
+  in.allowNoEOL();
+  in.open("input");
+  double a,c; int b; std::string s; int d;
+  while(in.scanField("c",s)) {
+    in.scanField("b",b).scanField("a",a);
+    if(in.FieldExist("d")) in.scanField("d",d);
+    else d=0;
+    in.scanField();
+    if(Tools::convert(s,c)) oo<<a<<" "<<b<<" "<<c<<" "<<d<<"\n";
+    else oo<<a<<" "<<b<<" "<<s.length()<<" "<<d<<"\n";
+  }
+  in.close();
+
+// conversions that are not plain numbers
+  for(const std::string str : {"1.5","  -2.5e1 "," +3","1.5-3","pi","-PI","2pi","1.2.3","0x10","abc","2147483648"}) {
+    double x=-1; int i=-1;
+    bool okx=Tools::convert(str,x);
+    bool oki=Tools::convert(str,i);
+    oo<<"'"<<str<<"' "<<okx<<" "<<x<<" "<<oki<<" "<<i<<"\n";
+  }
+  return 0;
+}
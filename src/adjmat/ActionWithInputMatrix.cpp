@@ -88,9 +88,9 @@ double ActionWithInputMatrix::retrieveConnectionValue( const unsigned& i, const
 void ActionWithInputMatrix::getInputData( const unsigned& ind, const bool& normed, const multicolvar::AtomValuePack& myatoms, std::vector<double>& orient0 ) const {
   if( (mymatrix->function)->mybasemulticolvars.size()==0  ) {
     std::vector<double> tvals( mymatrix->getNumberOfComponents() ); orient0.assign(orient0.size(),0);
-    for(unsigned i=0; i<mymatrix->getNumberOfColumns(); ++i) {
-      if( mymatrix->undirectedGraph() && ind==i ) continue;
-      orient0[1]+=retrieveConnectionValue( ind, i, tvals );
+    for(unsigned i=0; i<mymatrix->getNumberOfNonZerosInRow(ind); ++i) {
+      mymatrix->retrieveSequentialValue( mymatrix->getNonZeroInRow(ind,i).second, false, tvals );
+      orient0[1]+=tvals[0]*tvals[1];
     }
     orient0[0]=1.0; return;
   }
@@ -102,6 +102,15 @@ void ActionWithInputMatrix::addConnectionDerivatives( const unsigned& i, const u
   unsigned myelem = mymatrix->getStoreIndexFromMatrixIndices( i, j );
   // Get derivatives and add
   mymatrix->retrieveDerivatives( myelem, false, myvals );
+  addDerivativesOfConnection( myvals, myvout );
+}
+
+void ActionWithInputMatrix::addStoredElementDerivatives( const unsigned& jelem, MultiValue& myvals, MultiValue& myvout ) const {
+  mymatrix->retrieveSequentialDerivatives( jelem, false, myvals );
+  addDerivativesOfConnection( myvals, myvout );
+}
+
+void ActionWithInputMatrix::addDerivativesOfConnection( const MultiValue& myvals, MultiValue& myvout ) const {
   for(unsigned jd=0; jd<myvals.getNumberActive(); ++jd) {
     unsigned ider=myvals.getActiveIndex(jd);
     myvout.addDerivative( 1, ider, myvals.getDerivative( 1, ider ) );
@@ -116,9 +125,8 @@ MultiValue& ActionWithInputMatrix::getInputDerivatives( const unsigned& ind, con
     }
     myder.clearAll();
     MultiValue myvals( (mymatrix->function)->getNumberOfQuantities(), (mymatrix->function)->getNumberOfDerivatives() );
-    for(unsigned i=0; i<mymatrix->getNumberOfColumns(); ++i) {
-      if( mymatrix->undirectedGraph() && ind==i ) continue;
-      addConnectionDerivatives( ind, i, myvals, myder );
+    for(unsigned i=0; i<mymatrix->getNumberOfNonZerosInRow(ind); ++i) {
+      addStoredElementDerivatives( mymatrix->getNonZeroInRow(ind,i).second, myvals, myder );
     }
     myder.updateDynamicList(); return myder;
   }
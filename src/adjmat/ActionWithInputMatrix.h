@@ -41,6 +41,11 @@ protected:
   unsigned getNumberOfAtomsInGroup( const unsigned& igrp ) const ;
 /// Get a pointer to the igrp th base multicolvar
   multicolvar::MultiColvarBase* getBaseMultiColvar( const unsigned& igrp ) const ;
+/// Add the derivatives of the jelem th stored element of the matrix
+  void addStoredElementDerivatives( const unsigned& jelem, MultiValue& myvals, MultiValue& myvout ) const ;
+private:
+/// Add the derivatives of a connection that have been retrieved from the matrix to myvout
+  void addDerivativesOfConnection( const MultiValue& myvals, MultiValue& myvout ) const ;
 public:
   static void registerKeywords( Keywords& keys );
   explicit ActionWithInputMatrix(const ActionOptions&);
@@ -23,6 +23,8 @@
 #include "AdjacencyMatrixBase.h"
 #include "vesselbase/ActionWithVessel.h"
 
+#include <algorithm>
+
 namespace PLMD {
 namespace adjmat {
 
@@ -84,20 +86,58 @@ void AdjacencyMatrixVessel::getMatrixIndices( const unsigned& code, unsigned& i,
   if( !undirectedGraph() ) j -= function->ablocks[0].size(); // Have to remove number of columns as returns number in ablocks[1]
 }
 
-void AdjacencyMatrixVessel::retrieveMatrix( DynamicList<unsigned>& myactive_elements, Matrix<double>& mymatrix ) {
-  unsigned vin; double df;
-  myactive_elements.deactivateAll(); std::vector<double> vals( getNumberOfComponents() );
+void AdjacencyMatrixVessel::finish( const std::vector<double>& buffer ) {
+  StoreDataVessel::finish( buffer ); buildSparseStorage();
+}
+
+void AdjacencyMatrixVessel::buildSparseStorage() {
+  row_start.assign( getNumberOfRows()+1, 0 );
+  if( !symmetric ) col_start.assign( getNumberOfColumns()+1, 0 );
+
+  // Find the non-zero elements and count how many there are in each row and column
+  std::vector<double> myvals( getNumberOfComponents() );
+  std::vector<unsigned> nz_elem, nz_row, nz_col;
   for(unsigned i=0; i<getNumberOfStoredValues(); ++i) {
-    retrieveSequentialValue( i, false, vals );
-    if( vals[0]<epsilon ) continue ;
+    retrieveSequentialValue( i, false, myvals );
+    if( myvals[0]<=epsilon ) continue ;
 
-    myactive_elements.activate(i);
     unsigned j, k; getMatrixIndices( function->getPositionInFullTaskList(i), k, j );
+    nz_elem.push_back( i ); nz_row.push_back( k ); nz_col.push_back( j );
+    row_start[k+1]++;
+    if( symmetric ) row_start[j+1]++;
+    else col_start[j+1]++;
+  }
+  for(unsigned i=1; i<row_start.size(); ++i) row_start[i]+=row_start[i-1];
+  for(unsigned i=1; i<col_start.size(); ++i) col_start[i]+=col_start[i-1];
+
+  // And put the elements in their rows and columns
+  row_nonzero.resize( row_start[getNumberOfRows()] );
+  std::vector<unsigned> rpos( row_start.begin(), row_start.end()-1 ), cpos;
+  if( !symmetric ) {
+    col_nonzero.resize( col_start[getNumberOfColumns()] );
+    cpos.assign( col_start.begin(), col_start.end()-1 );
+  }
+  for(unsigned i=0; i<nz_elem.size(); ++i) {
+    row_nonzero[ rpos[nz_row[i]]++ ] = std::pair<unsigned,unsigned>( nz_col[i], nz_elem[i] );
+    if( symmetric ) row_nonzero[ rpos[nz_col[i]]++ ] = std::pair<unsigned,unsigned>( nz_row[i], nz_elem[i] );
+    else col_nonzero[ cpos[nz_col[i]]++ ] = std::pair<unsigned,unsigned>( nz_row[i], nz_elem[i] );
+  }
+  // Elements of symmetric matrices are stored in the order of the lower triangle so rows must be sorted
+  if( symmetric ) {
+    for(unsigned i=0; i<getNumberOfRows(); ++i) std::sort( row_nonzero.begin()+row_start[i], row_nonzero.begin()+row_start[i+1] );
+  }
+}
 
-    if( symmetric ) mymatrix(k,j)=mymatrix(j,k)=vals[0]*vals[1];
-    else mymatrix(k,j)=vals[0]*vals[1];
+void AdjacencyMatrixVessel::retrieveMatrix( Matrix<double>& mymatrix ) {
+  mymatrix=0;
+  std::vector<double> vals( getNumberOfComponents() );
+  for(unsigned k=0; k<getNumberOfRows(); ++k) {
+    for(unsigned i=row_start[k]; i<row_start[k+1]; ++i) {
+      unsigned j=row_nonzero[i].first;
+      retrieveSequentialValue( row_nonzero[i].second, false, vals );
+      mymatrix(k,j)=vals[0]*vals[1];
+    }
   }
-  myactive_elements.updateActiveMembers();
 }
 
 void AdjacencyMatrixVessel::retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list ) {
@@ -137,6 +177,20 @@ void AdjacencyMatrixVessel::retrieveEdgeList( unsigned& nedge, std::vector<std::
   }
 }
 
+void mult( const AdjacencyMatrixVessel& A, const std::vector<double>& x, std::vector<double>& y ) {
+  plumed_dbg_assert( x.size()==A.getNumberOfColumns() );
+  if( y.size()!=A.getNumberOfRows() ) y.resize( A.getNumberOfRows() );
+  std::vector<double> vals( A.getNumberOfComponents() );
+  for(unsigned i=0; i<A.getNumberOfRows(); ++i) {
+    y[i]=0;
+    for(unsigned j=0; j<A.getNumberOfNonZerosInRow(i); ++j) {
+      const std::pair<unsigned,unsigned>& nz( A.getNonZeroInRow(i,j) );
+      A.retrieveSequentialValue( nz.second, false, vals );
+      y[i]+=vals[0]*vals[1]*x[nz.first];
+    }
+  }
+}
+
 bool AdjacencyMatrixVessel::nodesAreConnected( const unsigned& iatom, const unsigned& jatom ) const {
   if( !matrixElementIsActive( iatom, jatom ) ) return false;
   unsigned ind=getStoreIndexFromMatrixIndices( iatom, jatom );
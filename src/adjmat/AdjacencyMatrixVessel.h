@@ -44,6 +44,17 @@ private:
   AdjacencyMatrixBase* function;
 /// Is the matrix symmetric and are we calculating hbonds
   bool symmetric, hbonds;
+/// Compressed sparse row representation of the non-zero elements of the matrix.  The
+/// non-zero elements of row i are the pairs (column, stored element) in positions
+/// row_start[i] to row_start[i+1]-1 of row_nonzero.  For symmetric matrices each
+/// element appears in the rows of both the nodes that it connects.
+  std::vector<unsigned> row_start;
+  std::vector<std::pair<unsigned,unsigned> > row_nonzero;
+/// Compressed sparse column representation (this is not built if the matrix is symmetric)
+  std::vector<unsigned> col_start;
+  std::vector<std::pair<unsigned,unsigned> > col_nonzero;
+/// Build the sparse representations from the stored data
+  void buildSparseStorage();
 public:
   static void registerKeywords( Keywords& keys );
 /// Constructor
@@ -54,8 +65,18 @@ public:
   bool matrixElementIsActive( const unsigned& ielem, const unsigned& jelem ) const ;
 /// Get the index that a particular element is stored in from the matrix indices
   unsigned getStoreIndexFromMatrixIndices( const unsigned& ielem, const unsigned& jelem ) const ;
+/// Store the data and construct the lists of non-zero elements
+  void finish( const std::vector<double>& buffer );
+/// Get the number of non-zero elements in row i
+  unsigned getNumberOfNonZerosInRow( const unsigned& i ) const ;
+/// Get the column and the stored element for the jth non-zero element in row i
+  const std::pair<unsigned,unsigned>& getNonZeroInRow( const unsigned& i, const unsigned& j ) const ;
+/// Get the number of non-zero elements in column i
+  unsigned getNumberOfNonZerosInColumn( const unsigned& i ) const ;
+/// Get the row and the stored element for the jth non-zero element in column i
+  const std::pair<unsigned,unsigned>& getNonZeroInColumn( const unsigned& i, const unsigned& j ) const ;
 /// Get the adjacency matrix
-  void retrieveMatrix( DynamicList<unsigned>& myactive_elements, Matrix<double>& mymatrix );
+  void retrieveMatrix( Matrix<double>& mymatrix );
 /// Get the neighbour list based on the adjacency matrix
   void retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list );
 /// Retrieve the list of edges in the adjacency matrix/graph
@@ -78,6 +99,35 @@ public:
   Vector getNodePosition( const unsigned& taskIndex ) const ;
 };
 
+/// Multiply the adjacency matrix by a vector using the lists of non-zero elements
+void mult( const AdjacencyMatrixVessel& A, const std::vector<double>& x, std::vector<double>& y );
+
+inline
+unsigned AdjacencyMatrixVessel::getNumberOfNonZerosInRow( const unsigned& i ) const {
+  plumed_dbg_assert( i+1<row_start.size() );
+  return row_start[i+1] - row_start[i];
+}
+
+inline
+const std::pair<unsigned,unsigned>& AdjacencyMatrixVessel::getNonZeroInRow( const unsigned& i, const unsigned& j ) const {
+  plumed_dbg_assert( j<getNumberOfNonZerosInRow(i) );
+  return row_nonzero[row_start[i]+j];
+}
+
+inline
+unsigned AdjacencyMatrixVessel::getNumberOfNonZerosInColumn( const unsigned& i ) const {
+  if( symmetric ) return getNumberOfNonZerosInRow( i );
+  plumed_dbg_assert( i+1<col_start.size() );
+  return col_start[i+1] - col_start[i];
+}
+
+inline
+const std::pair<unsigned,unsigned>& AdjacencyMatrixVessel::getNonZeroInColumn( const unsigned& i, const unsigned& j ) const {
+  if( symmetric ) return getNonZeroInRow( i, j );
+  plumed_dbg_assert( j<getNumberOfNonZerosInColumn(i) );
+  return col_nonzero[col_start[i]+j];
+}
+
 }
 }
 #endif
@@ -22,10 +22,25 @@
 #include "ClusteringBase.h"
 #include "AdjacencyMatrixBase.h"
 #include "AdjacencyMatrixVessel.h"
+#include "tools/OpenMP.h"
+#include "tools/Communicator.h"
 
 namespace PLMD {
 namespace adjmat {
 
+/// Find the root of a node in a union-find forest, with path halving
+static unsigned findRoot( std::vector<unsigned>& parent, unsigned i ) {
+  while( parent[i]!=i ) { parent[i]=parent[parent[i]]; i=parent[i]; }
+  return i;
+}
+
+/// Merge the trees of two nodes, the root with the lowest index becomes the root of both
+static void unite( std::vector<unsigned>& parent, const unsigned& i, const unsigned& j ) {
+  unsigned ri=findRoot( parent, i ), rj=findRoot( parent, j );
+  if( ri<rj ) parent[rj]=ri;
+  else if( rj<ri ) parent[ri]=rj;
+}
+
 void ClusteringBase::registerKeywords( Keywords& keys ) {
   ActionWithInputMatrix::registerKeywords( keys );
 }
@@ -64,6 +79,70 @@ void ClusteringBase::calculate() {
   std::sort( cluster_sizes.begin(), cluster_sizes.end() );
 }
 
+void ClusteringBase::performUnionFindClustering() {
+  AdjacencyMatrixVessel* mat=getAdjacencyVessel();
+  unsigned nnodes=getNumberOfNodes();
+  unsigned stride=comm.Get_size(), rank=comm.Get_rank();
+  if( serialCalculation() ) { stride=1; rank=0; }
+
+  // Each process takes care of a contiguous chunk of the rows of the matrix
+  unsigned chunk=(nnodes+stride-1)/stride;
+  unsigned start=rank*chunk; if( start>nnodes ) start=nnodes;
+  unsigned end=start+chunk; if( end>nnodes ) end=nnodes;
+  unsigned nt=OpenMP::getNumThreads();
+  if( nt*10>end-start ) nt=(end-start)/10;
+  if( nt==0 ) nt=1;
+
+  // Each thread builds its own forest from the non-zero elements in its rows.  The forests are set up
+  // here as fewer threads than requested may be spawned (e.g. in nested parallel regions)
+  std::vector<std::vector<unsigned> > forest( nt, std::vector<unsigned>( nnodes ) );
+  for(unsigned t=0; t<nt; ++t) for(unsigned i=0; i<nnodes; ++i) forest[t][i]=i;
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<unsigned>& parent( forest[OpenMP::getThreadNum()] );
+    std::vector<double> myvals( mat->getNumberOfComponents() );
+    #pragma omp for
+    for(unsigned k=start; k<end; ++k) {
+      for(unsigned i=0; i<mat->getNumberOfNonZerosInRow(k); ++i) {
+        const std::pair<unsigned,unsigned>& nz( mat->getNonZeroInRow(k,i) );
+        // Elements of symmetric matrices appear in two rows
+        if( mat->isSymmetric() && nz.first<k ) continue;
+        mat->retrieveSequentialValue( nz.second, false, myvals );
+        if( myvals[1]>=epsilon ) unite( parent, k, nz.first );
+      }
+    }
+  }
+  // Merge the forests of the threads
+  std::vector<unsigned>& parent( forest[0] );
+  for(unsigned t=1; t<nt; ++t) {
+    for(unsigned i=0; i<nnodes; ++i) if( forest[t][i]!=i ) unite( parent, i, forest[t][i] );
+  }
+  // Merge the forests of the processes, only the links of nodes that are not roots are exchanged
+  if( stride>1 ) {
+    std::vector<unsigned> links;
+    for(unsigned i=0; i<nnodes; ++i) {
+      unsigned r=findRoot( parent, i );
+      if( r!=i ) { links.push_back(i); links.push_back(r); }
+    }
+    int nlinks=links.size(); std::vector<int> counts( stride ), displs( stride );
+    comm.Allgather( nlinks, counts );
+    displs[0]=0; for(unsigned i=1; i<stride; ++i) displs[i]=displs[i-1]+counts[i-1];
+    std::vector<unsigned> alllinks( displs[stride-1]+counts[stride-1] );
+    if( links.empty() ) links.resize(1);
+    if( alllinks.empty() ) alllinks.resize(1);
+    comm.Allgatherv( &links[0], nlinks, &alllinks[0], &counts[0], &displs[0] );
+    for(int i=0; i<displs[stride-1]+counts[stride-1]; i+=2) unite( parent, alllinks[i], alllinks[i+1] );
+  }
+
+  // Label the clusters in order of their first node
+  std::vector<int> label( nnodes, -1 ); number_of_cluster=-1;
+  for(unsigned i=0; i<nnodes; ++i) {
+    unsigned r=findRoot( parent, i );
+    if( label[r]<0 ) { number_of_cluster++; label[r]=number_of_cluster; }
+    which_cluster[i]=label[r]; cluster_sizes[which_cluster[i]].first++;
+  }
+}
+
 void ClusteringBase::retrieveAtomsInCluster( const unsigned& clust, std::vector<unsigned>& myatoms ) const {
   unsigned n=0; myatoms.resize( cluster_sizes[cluster_sizes.size() - clust].first );
   for(unsigned i=0; i<getNumberOfNodes(); ++i) {
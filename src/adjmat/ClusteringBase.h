@@ -49,6 +49,10 @@ public:
   void calculate();
 /// Do the clustering
   virtual void performClustering()=0;
+/// Find the connected components of the graph with a union-find algorithm.
+/// Edges are processed in chunks by the different processes and threads, whose forests are then merged.
+/// Clusters are numbered in order of their first node, as in a depth first search
+  void performUnionFindClustering();
 /// Get the number of clusters that have been found
   unsigned getNumberOfClusters() const ;
 /// Get the atoms in one of the clusters
@@ -40,6 +40,8 @@ these matrices provide a representation of a graph and can thus can be analysed
 a depth first search clustering to find the connected components of this graph.  You can read more about depth first search here:
 
 https://en.wikipedia.org/wiki/Depth-first_search
+Unless PLUMED is compiled with boost graph, the connected components are actually found using a union-find algorithm,
+which gives the same clusters, is not recursive and can be run in parallel.
 
 This action is useful if you are looking at a phenomenon such as nucleation where the aim is to detect the sizes of the crystalline nuclei that have formed
 in your simulation cell.
@@ -72,15 +74,6 @@ private:
 #ifdef __PLUMED_HAS_BOOST_GRAPH
 /// The list of edges in the graph
   std::vector<std::pair<unsigned,unsigned> > edge_list;
-#else
-/// The number of neighbors each atom has
-  std::vector<unsigned> nneigh;
-/// The adjacency list
-  Matrix<unsigned> adj_list;
-/// The color that tells us whether a node has been visited
-  std::vector<unsigned> color;
-/// The recursive function at the heart of this method
-  int explore( const unsigned& index );
 #endif
 public:
 /// Create manual
@@ -98,7 +91,8 @@ void DFSClustering::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","MAXCONNECT","0","maximum number of connections that can be formed by any given node in the graph. "
            "By default this is set equal to zero and the number of connections is set equal to the number "
            "of nodes.  You only really need to set this if you are working with a very large system and "
-           "memory is at a premium");
+           "memory is at a premium.  This is only used when PLUMED is compiled with boost graph, otherwise "
+           "the connected components are found with a union-find algorithm that does not need this");
 }
 
 DFSClustering::DFSClustering(const ActionOptions&ao):
@@ -109,10 +103,6 @@ DFSClustering::DFSClustering(const ActionOptions&ao):
 #ifdef __PLUMED_HAS_BOOST_GRAPH
   if( maxconnections>0 ) edge_list.resize( getNumberOfNodes()*maxconnections );
   else edge_list.resize(0.5*getNumberOfNodes()*(getNumberOfNodes()-1));
-#else
-  nneigh.resize( getNumberOfNodes() ); color.resize(getNumberOfNodes());
-  if( maxconnections>0 ) adj_list.resize(getNumberOfNodes(),maxconnections);
-  else adj_list.resize(getNumberOfNodes(),getNumberOfNodes());
 #endif
 }
 
@@ -130,32 +120,10 @@ void DFSClustering::performClustering() {
   // And work out the size of each cluster
   for(unsigned i=0; i<which_cluster.size(); ++i) cluster_sizes[which_cluster[i]].first++;
 #else
-  // Get the adjacency matrix
-  getAdjacencyVessel()->retrieveAdjacencyLists( nneigh, adj_list );
-
-  // Perform clustering
-  number_of_cluster=-1; color.assign(color.size(),0);
-  for(unsigned i=0; i<getNumberOfNodes(); ++i) {
-    if( color[i]==0 ) { number_of_cluster++; color[i]=explore(i); }
-  }
+  // Find the connected components with union-find, which is parallel and not recursive
+  performUnionFindClustering();
 #endif
 }
 
-#ifndef __PLUMED_HAS_BOOST_GRAPH
-int DFSClustering::explore( const unsigned& index ) {
-
-  color[index]=1;
-  for(unsigned i=0; i<nneigh[index]; ++i) {
-    unsigned j=adj_list(index,i);
-    if( color[j]==0 ) color[j]=explore(j);
-  }
-
-  // Count the size of the cluster
-  cluster_sizes[number_of_cluster].first++;
-  which_cluster[index] = number_of_cluster;
-  return color[index];
-}
-#endif
-
 }
 }
@@ -101,19 +101,16 @@ MatrixColumnSums::MatrixColumnSums(const ActionOptions& ao):
 
 double MatrixColumnSums::compute( const unsigned& tinded, multicolvar::AtomValuePack& myatoms ) const {
   double sum=0.0; std::vector<double> tvals( mymatrix->getNumberOfComponents() );
-  unsigned nrows = mymatrix->getNumberOfRows();
-  for(unsigned i=0; i<nrows; ++i) {
-    if( mymatrix->undirectedGraph() && tinded==i ) continue;
-    sum+=retrieveConnectionValue( i, tinded, tvals );
+  unsigned nnz = mymatrix->getNumberOfNonZerosInColumn( tinded );
+  for(unsigned i=0; i<nnz; ++i) {
+    mymatrix->retrieveSequentialValue( mymatrix->getNonZeroInColumn( tinded, i ).second, false, tvals );
+    sum+=tvals[0]*tvals[1];
   }
 
   if( !doNotCalculateDerivatives() ) {
     MultiValue myvals( mymatrix->getNumberOfComponents(), myatoms.getNumberOfDerivatives() );
     MultiValue& myvout=myatoms.getUnderlyingMultiValue();
-    for(unsigned i=0; i<nrows; ++i) {
-      if( mymatrix->isSymmetric() && tinded==i ) continue ;
-      addConnectionDerivatives( i, tinded, myvals, myvout );
-    }
+    for(unsigned i=0; i<nnz; ++i) addStoredElementDerivatives( mymatrix->getNonZeroInColumn( tinded, i ).second, myvals, myvout );
   }
   return sum;
 }
@@ -86,14 +86,15 @@ private:
   double sqrtn;
 /// Vector that stores eigenvalues
   std::vector<double> eigvals;
-/// This is used to speed up the calculation of derivatives
-  DynamicList<unsigned> active_elements;
 /// Vector that stores max eigenvector
   std::vector< std::pair<double,int> > maxeig;
 /// Adjacency matrix
   Matrix<double> thematrix;
 /// Matrix that stores eigenvectors
   Matrix<double> eigenvecs;
+/// The largest eigenvalue and its eigenvector when they are found without a full diagonalization
+  std::vector<double> princval;
+  Matrix<double> princvec;
 public:
 /// Create manual
   static void registerKeywords( Keywords& keys );
@@ -121,7 +122,9 @@ Sprint::Sprint(const ActionOptions&ao):
   eigvals( getNumberOfNodes() ),
   maxeig( getNumberOfNodes() ),
   thematrix( getNumberOfNodes(), getNumberOfNodes() ),
-  eigenvecs( getNumberOfNodes(), getNumberOfNodes() )
+  eigenvecs( getNumberOfNodes(), getNumberOfNodes() ),
+  princval( 1 ),
+  princvec( 1, getNumberOfNodes() )
 {
   // Check on setup
   // if( getNumberOfVessels()!=1 ) error("there should be no vessel keywords");
@@ -142,25 +145,33 @@ Sprint::Sprint(const ActionOptions&ao):
     componentIsNotPeriodic("coord-"+num);
     getPntrToComponent(i)->resizeDerivatives( getNumberOfDerivatives() );
   }
-
-  // Setup the dynamic list to hold all the tasks
-  unsigned ntriangle = 0.5*getNumberOfNodes()*(getNumberOfNodes()-1);
-  for(unsigned i=0; i<ntriangle; ++i) active_elements.addIndexToList( i );
 }
 
 void Sprint::calculate() {
-  // Get the adjacency matrix
-  getAdjacencyVessel()->retrieveMatrix( active_elements, thematrix );
-  // Diagonalize it
-  diagMat( thematrix, eigvals, eigenvecs );
-  // Get the maximum eigevalue
-  double lambda = eigvals[ getNumberOfNodes()-1 ];
-  // Get the corresponding eigenvector
-  for(unsigned j=0; j<maxeig.size(); ++j) {
-    maxeig[j].first = fabs( eigenvecs( getNumberOfNodes()-1, j ) );
-    maxeig[j].second = j;
-    // Must make all components of principle eigenvector +ve
-    eigenvecs( getNumberOfNodes()-1, j ) = maxeig[j].first;
+  double lambda;
+  if( doNotCalculateDerivatives() ) {
+    // Only the largest eigenvalue and its eigenvector are needed so they are found iteratively
+    // from the sparse adjacency matrix starting from the eigenvector found at the previous step
+    if( lanczos( *getAdjacencyVessel(), getNumberOfNodes(), 1, princval, princvec, true )!=0 ) error("lanczos did not converge");
+    lambda = princval[0];
+    for(unsigned j=0; j<maxeig.size(); ++j) {
+      maxeig[j].first = fabs( princvec( 0, j ) );
+      maxeig[j].second = j;
+    }
+  } else {
+    // The derivatives need all the eigenvalues and eigenvectors
+    getAdjacencyVessel()->retrieveMatrix( thematrix );
+    // Diagonalize it
+    diagMat( thematrix, eigvals, eigenvecs );
+    // Get the maximum eigevalue
+    lambda = eigvals[ getNumberOfNodes()-1 ];
+    // Get the corresponding eigenvector
+    for(unsigned j=0; j<maxeig.size(); ++j) {
+      maxeig[j].first = fabs( eigenvecs( getNumberOfNodes()-1, j ) );
+      maxeig[j].second = j;
+      // Must make all components of principle eigenvector +ve
+      eigenvecs( getNumberOfNodes()-1, j ) = maxeig[j].first;
+    }
   }
 
   // Reorder each block of eigevectors
@@ -176,6 +187,7 @@ void Sprint::calculate() {
   for(unsigned icomp=0; icomp<getNumberOfComponents(); ++icomp) {
     getPntrToComponent(icomp)->set( sqrtn*lambda*maxeig[icomp].first );
   }
+  if( doNotCalculateDerivatives() ) return;
 
   // Parallelism
   unsigned rank, stride;
@@ -186,20 +198,27 @@ void Sprint::calculate() {
   MultiValue myvals( 2, getNumberOfDerivatives() );
   Matrix<double> mymat_ders( getNumberOfComponents(), getNumberOfDerivatives() );
   // std::vector<unsigned> catoms(2);
-  unsigned nval = getNumberOfNodes(); mymat_ders=0;
-  for(unsigned i=rank; i<active_elements.getNumberActive(); i+=stride) {
-    unsigned j, k; getAdjacencyVessel()->getMatrixIndices( active_elements[i], j, k );
-    double tmp1 = 2 * eigenvecs(nval-1,j)*eigenvecs(nval-1,k);
-    for(unsigned icomp=0; icomp<getNumberOfComponents(); ++icomp) {
-      double tmp2 = 0.;
-      for(unsigned n=0; n<nval-1; ++n) { // Need care on following line
-        tmp2 += eigenvecs(n,maxeig[icomp].second) * ( eigenvecs(n,j)*eigenvecs(nval-1,k) + eigenvecs(n,k)*eigenvecs(nval-1,j) ) / ( lambda - eigvals[n] );
-      }
-      double prefactor=sqrtn*( tmp1*maxeig[icomp].first + tmp2*lambda );
-      getAdjacencyVessel()->retrieveDerivatives( active_elements[i], false, myvals );
-      for(unsigned jd=0; jd<myvals.getNumberActive(); ++jd) {
-        unsigned ider=myvals.getActiveIndex(jd);
-        mymat_ders( icomp, ider ) += prefactor*myvals.getDerivative( 1, ider );
+  unsigned nval = getNumberOfNodes(), ielem = 0; mymat_ders=0;
+  AdjacencyMatrixVessel* mat=getAdjacencyVessel();
+  for(unsigned j=0; j<nval; ++j) {
+    for(unsigned i=0; i<mat->getNumberOfNonZerosInRow(j); ++i) {
+      // Each element is in two rows of the symmetric matrix so only the upper triangle is used
+      unsigned k=mat->getNonZeroInRow(j,i).first;
+      if( k<j ) continue;
+      if( (ielem++)%stride!=rank ) continue;
+
+      mat->retrieveSequentialDerivatives( mat->getNonZeroInRow(j,i).second, false, myvals );
+      double tmp1 = 2 * eigenvecs(nval-1,j)*eigenvecs(nval-1,k);
+      for(unsigned icomp=0; icomp<getNumberOfComponents(); ++icomp) {
+        double tmp2 = 0.;
+        for(unsigned n=0; n<nval-1; ++n) { // Need care on following line
+          tmp2 += eigenvecs(n,maxeig[icomp].second) * ( eigenvecs(n,j)*eigenvecs(nval-1,k) + eigenvecs(n,k)*eigenvecs(nval-1,j) ) / ( lambda - eigvals[n] );
+        }
+        double prefactor=sqrtn*( tmp1*maxeig[icomp].first + tmp2*lambda );
+        for(unsigned jd=0; jd<myvals.getNumberActive(); ++jd) {
+          unsigned ider=myvals.getActiveIndex(jd);
+          mymat_ders( icomp, ider ) += prefactor*myvals.getDerivative( 1, ider );
+        }
       }
     }
   }
@@ -42,6 +42,8 @@ void Analysis::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","RUN","0","the frequency with which to run the analysis algorithm. The default value of zero assumes you want to analyse the whole trajectory");
   keys.add("optional","FMT","the format that should be used in analysis output files");
   keys.addFlag("WRITE_CHECKPOINT",false,"write out a checkpoint so that the analysis can be restarted in a later run");
+  keys.addFlag("STORE_ON_DISK",false,"store the data that is to be analyzed in a binary file rather than in memory.  This file is read in chunks "
+               "when the analysis is performed so that long trajectories can be analyzed using a limited amount of memory");
   keys.add("hidden","REUSE_DATA_FROM","eventually this will allow you to analyse the same set of data multiple times");
   keys.add("hidden","IGNORE_REWEIGHTING","this allows you to ignore any reweighting factors");
   keys.use("RESTART"); keys.use("UPDATE_FROM"); keys.use("UPDATE_UNTIL"); keys.remove("TOL");
@@ -59,8 +61,13 @@ Analysis::Analysis(const ActionOptions&ao):
 //old_norm(0.0),
   ofmt("%f"),
   current_args(getNumberOfArguments()),
+  ondisk(false),
+  diskfp(NULL),
+  nwritten(0),
+  usecount(0),
   argument_names(getNumberOfArguments())
 {
+  cachedchunk[0]=cachedchunk[1]=-1; lastuse[0]=lastuse[1]=0;
   parse("FMT",ofmt);  // Read the format for output files
   // Make a vector containing all the argument names
   for(unsigned i=0; i<getNumberOfArguments(); ++i) argument_names[i]=getPntrToArgument(i)->getName();
@@ -91,18 +98,35 @@ Analysis::Analysis(const ActionOptions&ao):
     if( ignore_reweight ) log.printf("  reusing data stored by %s but ignoring all reweighting\n",prev_analysis.c_str() );
     else log.printf("  reusing data stored by %s\n",prev_analysis.c_str() );
   } else {
+    parseFlag("STORE_ON_DISK",ondisk);
     parse("RUN",freq);
     if( freq==0 ) {
       log.printf("  analyzing all data in trajectory\n");
     } else {
       if( freq%getStride()!=0 ) error("frequncy of running is not a multiple of the stride");
       log.printf("  running analysis every %u steps\n",freq);
-      ndata=freq/getStride(); data.resize( ndata ); logweights.resize( ndata );
-      for(unsigned i=0; i<ndata; ++i) {
+      ndata=freq/getStride(); logweights.resize( ndata );
+      if( ondisk ) diskweights.resize( ndata );
+      else data.resize( ndata );
+      for(unsigned i=0; i<data.size(); ++i) {
         data[i]=metricRegister().create<ReferenceConfiguration>( metricname );
         data[i]->setNamesAndAtomNumbers( getAbsoluteIndexes(), argument_names );
       }
     }
+    if( ondisk ) {
+      // Configurations that hold the two chunks of data that are in memory
+      data.resize( 2*chunksize );
+      for(unsigned i=0; i<data.size(); ++i) {
+        data[i]=metricRegister().create<ReferenceConfiguration>( metricname );
+        data[i]->setNamesAndAtomNumbers( getAbsoluteIndexes(), argument_names );
+      }
+      // Each process has its own copy of the data
+      diskfile = getLabel() + ".analysis_frames" + plumed.getSuffix();
+      if( comm.Get_size()>1 ) { std::string num; Tools::convert( comm.Get_rank(), num ); diskfile += "." + num; }
+      diskfp=std::fopen( diskfile.c_str(), "w+b" );
+      if( !diskfp ) error("could not open file " + diskfile + " to store data");
+      log.printf("  storing data in file %s and reading it in chunks of %u frames\n",diskfile.c_str(),chunksize);
+    }
     parseFlag("WRITE_CHECKPOINT",write_chq);
     if( write_chq ) {
       write_chq=false;
@@ -140,14 +164,17 @@ void Analysis::readDataFromFile( const std::string& filename ) {
       PDB mypdb;
       do_read=mypdb.readFromFilepointer(fp,plumed.getAtoms().usingNaturalUnits(),0.1/atoms.getUnits().getLength());
       if(do_read) {
-        data[idata]->set( mypdb );
-        data[idata]->parse("TIME",tstep);
+        // When the data is on disk the configuration is read into the first buffer and then stored
+        ReferenceConfiguration* conf=( ondisk ? data[0] : data[idata] );
+        conf->set( mypdb );
+        conf->parse("TIME",tstep);
         if( !first && ((tstep-oldtstep) - getStride()*plumed.getAtoms().getTimeStep())>plumed.getAtoms().getTimeStep() ) {
           error("frequency of data storage in " + filename + " is not equal to frequency of data storage plumed.dat file");
         }
-        data[idata]->parse("LOG_WEIGHT",logweights[idata]);
+        conf->parse("LOG_WEIGHT",logweights[idata]);
         //data[idata]->parse("OLD_NORM",old_norm);
-        data[idata]->checkRead();
+        conf->checkRead();
+        if( ondisk ) storeFrameOnDisk( conf->getReferencePositions(), conf->getReferenceArguments() );
         idata++; first=false; oldtstep=tstep;
       } else {
         break;
@@ -177,7 +204,11 @@ void Analysis::accumulate() {
   // Get the arguments ready to transfer to reference configuration
   for(unsigned i=0; i<getNumberOfArguments(); ++i) current_args[i]=getArgument(i);
 
-  if( freq>0) {
+  if( ondisk ) {
+    storeFrameOnDisk( getPositions(), current_args );
+    if( freq>0 ) logweights[idata] = lweight;
+    else { logweights.push_back(lweight); diskweights.push_back(0.0); }
+  } else if( freq>0) {
     // Get the arguments and store them in a vector of vectors
     data[idata]->setReferenceConfig( getPositions(), current_args, getMetric() );
     logweights[idata] = lweight;
@@ -202,6 +233,67 @@ void Analysis::accumulate() {
 Analysis::~Analysis() {
   for(unsigned i=0; i<data.size(); ++i ) delete data[i];
   if( write_chq ) rfile.close();
+  if( diskfp ) { std::fclose( diskfp ); std::remove( diskfile.c_str() ); }
+}
+
+void Analysis::doNotStoreData() {
+  if( reusing_data ) error("cannot reuse data from another action when frames are analyzed as they are collected");
+  if( ondisk ) error("cannot use STORE_ON_DISK when frames are analyzed as they are collected");
+  for(unsigned i=0; i<data.size(); ++i ) delete data[i];
+  data.resize(0); logweights.resize(0);
+}
+
+void Analysis::storeFrameOnDisk( const std::vector<Vector>& pos, const std::vector<double>& args ) {
+  for(unsigned i=0; i<pos.size(); ++i) for(unsigned k=0; k<3; ++k) writebuffer.push_back( pos[i][k] );
+  for(unsigned i=0; i<args.size(); ++i) writebuffer.push_back( args[i] );
+  if( writebuffer.size()>=chunksize*( 3*getNumberOfAtoms() + getNumberOfArguments() ) ) flushFramesToDisk();
+}
+
+void Analysis::flushFramesToDisk() {
+  unsigned recsize=3*getNumberOfAtoms() + getNumberOfArguments();
+  if( recsize==0 || writebuffer.empty() ) return;
+  plumed_assert( writebuffer.size()%recsize==0 );
+  unsigned nframes=writebuffer.size()/recsize;
+  // Frames are always written after the ones that are already in the file
+  if( std::fseek( diskfp, static_cast<long>(nwritten)*recsize*sizeof(double), SEEK_SET )!=0 ||
+      std::fwrite( &writebuffer[0], sizeof(double), writebuffer.size(), diskfp )!=writebuffer.size() ) {
+    error("problem writing data to file " + diskfile );
+  }
+  nwritten+=nframes; writebuffer.resize(0);
+  // The chunks in memory might now be out of date
+  cachedchunk[0]=cachedchunk[1]=-1;
+}
+
+ReferenceConfiguration* Analysis::getStoredConfiguration( const unsigned& idata ) const {
+  if( reusing_data ) return mydatastash->getStoredConfiguration( idata );
+  plumed_dbg_assert( idata<getNumberOfDataPoints() );
+  if( !ondisk ) return data[idata];
+
+  int ichunk=idata/chunksize; usecount++;
+  for(unsigned s=0; s<2; ++s) {
+    if( cachedchunk[s]==ichunk ) { lastuse[s]=usecount; return data[s*chunksize + idata%chunksize]; }
+  }
+  // Read the chunk into the buffer that was used least recently
+  unsigned s=( lastuse[0]<=lastuse[1] ? 0 : 1 );
+  unsigned recsize=3*getNumberOfAtoms() + getNumberOfArguments();
+  unsigned start=ichunk*chunksize, nframes=std::min( chunksize, nwritten-start );
+  std::vector<double> readbuffer( nframes*recsize );
+  if( recsize>0 ) {
+    if( std::fseek( diskfp, static_cast<long>(start)*recsize*sizeof(double), SEEK_SET )!=0 ||
+        std::fread( &readbuffer[0], sizeof(double), readbuffer.size(), diskfp )!=readbuffer.size() ) {
+      plumed_merror("problem reading data from file " + diskfile );
+    }
+  }
+  std::vector<Vector> pos( getNumberOfAtoms() ); std::vector<double> args( getNumberOfArguments() );
+  for(unsigned i=0; i<nframes; ++i) {
+    unsigned k=i*recsize;
+    for(unsigned j=0; j<pos.size(); ++j) { pos[j][0]=readbuffer[k++]; pos[j][1]=readbuffer[k++]; pos[j][2]=readbuffer[k++]; }
+    for(unsigned j=0; j<args.size(); ++j) args[j]=readbuffer[k++];
+    data[s*chunksize + i]->setReferenceConfig( pos, args, getMetric() );
+    data[s*chunksize + i]->setWeight( diskweights[start+i] );
+  }
+  cachedchunk[s]=ichunk; lastuse[s]=usecount;
+  return data[s*chunksize + idata%chunksize];
 }
 
 std::vector<double> Analysis::getMetric() const {
@@ -215,7 +307,8 @@ std::vector<double> Analysis::getMetric() const {
 
 double Analysis::getWeight( const unsigned& idata ) const {
   if( !reusing_data ) {
-    plumed_dbg_assert( idata<data.size() );
+    plumed_dbg_assert( idata<getNumberOfDataPoints() );
+    if( ondisk ) return diskweights[idata];
     return data[idata]->getWeight();
   } else {
     return mydatastash->getWeight(idata);
@@ -229,7 +322,9 @@ void Analysis::finalizeWeights( const bool& ignore_weights ) {
   double norm=0;  // Reset normalization constant
   if( ignore_weights ) {
     for(unsigned i=0; i<logweights.size(); ++i) {
-      data[i]->setWeight(1.0); norm+=1.0;
+      if( ondisk ) diskweights[i]=1.0;
+      else data[i]->setWeight(1.0);
+      norm+=1.0;
     }
   } else if( nomemory ) {
     // Find the maximum weight
@@ -243,8 +338,11 @@ void Analysis::finalizeWeights( const bool& ignore_weights ) {
     }
     // Calculate weights (no memory)
     for(unsigned i=0; i<logweights.size(); ++i) {
-      data[i]->setWeight( exp( logweights[i]-maxweight ) );
+      if( ondisk ) diskweights[i]=exp( logweights[i]-maxweight );
+      else data[i]->setWeight( exp( logweights[i]-maxweight ) );
     }
+    // The weights of the chunks that are in memory have changed
+    cachedchunk[0]=cachedchunk[1]=-1;
     // Calculate normalized weights (with memory)
   } else {
     plumed_merror("analysis can now only support block averages");
@@ -266,8 +364,9 @@ void Analysis::getDataPoint( const unsigned& idata, std::vector<double>& point,
   plumed_dbg_assert( getNumberOfAtoms()==0 );
   if( !reusing_data ) {
     plumed_dbg_assert( idata<logweights.size() &&  point.size()==getNumberOfArguments() );
-    for(unsigned i=0; i<point.size(); ++i) point[i]=data[idata]->getReferenceArgument(i);
-    weight=data[idata]->getWeight();
+    ReferenceConfiguration* conf=getStoredConfiguration( idata );
+    for(unsigned i=0; i<point.size(); ++i) point[i]=conf->getReferenceArgument(i);
+    weight=conf->getWeight();
   } else {
     return mydatastash->getDataPoint( idata, point, weight );
   }
@@ -280,6 +379,7 @@ void Analysis::runAnalysis() {
 
   // Calculate the final weights from the log weights
   if( !reusing_data ) {
+    if( ondisk ) flushFramesToDisk();
     finalizeWeights( ignore_reweight );
   } else {
     mydatastash->finalizeWeights( ignore_reweight );
@@ -289,6 +389,8 @@ void Analysis::runAnalysis() {
   // if( single_run ) setAnalysisStride( single_run, freq );
   // And run the analysis
   performAnalysis(); idata=0;
+  // The next block of data overwrites this one in the file
+  if( ondisk && freq>0 ) { nwritten=0; cachedchunk[0]=cachedchunk[1]=-1; }
   // Update total normalization constant
   // old_norm+=norm; firstAnalysisDone=true;
 
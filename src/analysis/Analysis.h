@@ -23,6 +23,7 @@
 #define __PLUMED_analysis_Analysis_h
 
 #include "vesselbase/ActionWithAveraging.h"
+#include <cstdio>
 
 #define PLUMED_ANALYSIS_INIT(ao) Action(ao),Analysis(ao)
 
@@ -73,6 +74,26 @@ private:
   std::string ofmt;
 /// Tempory vector to store values of arguments
   std::vector<double> current_args;
+/// Are we storing the data in a binary file rather than in memory
+  bool ondisk;
+/// The number of frames in each of the chunks that are read from the file at once
+  static const unsigned chunksize=256;
+/// The name of the file that holds the data and the file itself
+  std::string diskfile;
+  FILE* diskfp;
+/// The number of frames that have been written to the file
+  unsigned nwritten;
+/// Frames that have not yet been written to the file
+  std::vector<double> writebuffer;
+/// The weights of the data points when they are stored on disk
+  std::vector<double> diskweights;
+/// The two chunks that are in memory and when they were last used
+  mutable int cachedchunk[2];
+  mutable unsigned lastuse[2], usecount;
+/// Store a frame in the file
+  void storeFrameOnDisk( const std::vector<Vector>& pos, const std::vector<double>& args );
+/// Write all the frames that are buffered to the file
+  void flushFramesToDisk();
 /// The type of metric we are using to measure distances
   std::string metricname;
 /// The checkpoint file
@@ -88,8 +109,12 @@ protected:
 /// this method is used and the calculation is not restarted old analysis
 /// files are backed up.
   void parseOutputFile( const std::string& key, std::string& filename );
-/// The data we are going to analyze
+/// The data we are going to analyze (when the data is on disk this holds the chunks that are in memory)
   std::vector<ReferenceConfiguration*> data;
+/// Get the idata th stored configuration.  When the data is stored on disk the chunk containing the
+/// configuration is read if it is not in memory, so the pointer remains valid only as long as no more
+/// than one other chunk of the data is accessed.  Loops over the data should thus be sequential.
+  ReferenceConfiguration* getStoredConfiguration( const unsigned& idata ) const ;
 /// Get the name of the metric we are using to measure distances
   std::string getMetricName() const ;
 /// Return the number of data points
@@ -104,6 +129,10 @@ protected:
   bool usingMemory() const;
 /// Return the format to use for numbers in output files
   std::string getOutputFormat() const ;
+/// Return the frequency with which the analysis is performed (zero if it is only performed at the end)
+  unsigned getRunFrequency() const ;
+/// Delete the storage for the data.  This is used by actions that process each frame as it is collected.
+  void doNotStoreData();
 /// Finalize the weights without using the log sums
 //  void finalizeWeightsNoLogSums( const double& onorm );
 public:
@@ -130,8 +159,8 @@ std::string Analysis::getMetricName() const {
 inline
 unsigned Analysis::getNumberOfDataPoints() const {
   if( !reusing_data ) {
-    plumed_dbg_assert( data.size()==logweights.size() );
-    return data.size();
+    plumed_dbg_assert( ondisk || data.size()==logweights.size() );
+    return logweights.size();
   } else {
     return mydatastash->getNumberOfDataPoints();
   }
@@ -151,6 +180,11 @@ std::string Analysis::getOutputFormat() const {
   return ofmt;
 }
 
+inline
+unsigned Analysis::getRunFrequency() const {
+  return freq;
+}
+
 }
 }
 
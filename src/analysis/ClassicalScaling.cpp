@@ -42,13 +42,14 @@ void ClassicalScaling::run( PointWiseMapping* mymap ) {
     for(unsigned j=0; j<n; ++j) distances(j,i) -= sum/n;
   }
 
-  // Diagonalize matrix
-  std::vector<double> eigval(n); Matrix<double> eigvec(n,n);
-  diagMat( distances, eigval, eigvec );
+  // Find the largest eigenvalues - only as many as the dimensionality of the projection are needed
+  unsigned nlow=mymap->getNumberOfProperties();
+  std::vector<double> eigval(nlow); Matrix<double> eigvec(nlow,n);
+  if( lanczos( distances, n, nlow, eigval, eigvec )!=0 ) plumed_merror("lanczos did not converge in classical scaling");
 
   // Pass final projections to map object
   for(unsigned i=0; i<n; ++i) {
-    for(unsigned j=0; j<mymap->getNumberOfProperties(); ++j) mymap->setProjectionCoordinate( i, j, sqrt(eigval[n-1-j])*eigvec(n-1-j,i) );
+    for(unsigned j=0; j<nlow; ++j) mymap->setProjectionCoordinate( i, j, sqrt(eigval[j])*eigvec(j,i) );
   }
 }
 
@@ -486,14 +486,13 @@ void Histogram::compute( const unsigned& current, MultiValue& myvals ) const {
     if( in_apply ) myvals.updateDynamicList();
   } else {
     plumed_assert( !in_apply );
-    std::vector<Value*> vv( myhist->getVectorOfValues() );
-    std::vector<double> val( getNumberOfArguments() ), der( getNumberOfArguments() );
+    std::vector<double> val( getNumberOfArguments() ), der( getNumberOfArguments() ), dp( getNumberOfArguments() );
     // Retrieve the location of the grid point at which we are evaluating the kernel
     mygrid->getGridPointCoordinates( current, val );
     if( kernel ) {
-      for(unsigned i=0; i<getNumberOfArguments(); ++i) vv[i]->set( val[i] );
+      myhist->getKernelDisplacement( val, kernel->getCenter(), &dp[0] );
       // Evaluate the histogram at the relevant grid point and set the values
-      double vvh = kernel->evaluate( vv, der,true); myvals.setValue( 1, vvh );
+      double vvh = kernel->evaluate( &dp[0], &der[0] ); myvals.setValue( 1, vvh );
     } else {
       plumed_merror("normalisation of vectors does not work with arguments and spherical grids");
       // Evalulate dot product
@@ -503,8 +502,8 @@ void Histogram::compute( const unsigned& current, MultiValue& myvals ) const {
       // And final derivatives
       for(unsigned j=0; j<getNumberOfArguments(); ++j) der[j] *= (myhist->von_misses_concentration)*newval;
     }
-    // Set the derivatives and delete the vector of values
-    for(unsigned i=0; i<getNumberOfArguments(); ++i) { myvals.setDerivative( 1, i, der[i] ); delete vv[i]; }
+    // Set the derivatives
+    for(unsigned i=0; i<getNumberOfArguments(); ++i) myvals.setDerivative( 1, i, der[i] );
   }
 }
 
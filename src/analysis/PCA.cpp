@@ -26,6 +26,7 @@
 #include "reference/ReferenceConfiguration.h"
 #include "reference/ReferenceValuePack.h"
 #include "core/ActionRegister.h"
+#include "tools/Communicator.h"
 
 //+PLUMEDOC DIMRED PCA
 /*
@@ -86,6 +87,18 @@ d6: DISTANCE ATOMS=3,4
 PCA ARG=d1,d2,d3,d4,d5,d6 METRIC=EUCLIDEAN STRIDE=5 RUN=1000 NLOW_DIM=2 REWEIGHT_BIAS OFILE=pca-comp.pdb
 \endplumedfile
 
+If the ONLINE flag is used the frames are not stored.  The average and the covariance are instead updated every time a frame
+is collected using the algorithm of Welford, so no memory is required for the trajectory and there is no pause while the
+stored data is analyzed.  In this mode the average and covariance are accumulated over the whole trajectory and the principal
+components of all the data collected so far are output every RUN steps, or at the end of the simulation if RUN is not used.  The
+atoms are aligned to the first frame that is collected.  When the WALKERS_MPI flag is also used the average and covariance
+from all the replicas are combined before the principal components are calculated, so that all the replicas output the same
+components.  The following input thus outputs the principal components of all the frames collected so far every 1000 steps.
+
+\plumedfile
+PCA METRIC=OPTIMAL ATOMS=1-22 STRIDE=1 RUN=1000 ONLINE NLOW_DIM=2 OFILE=pca-comp.pdb
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 
@@ -102,11 +115,28 @@ private:
 /// The eigenvectors for the displacements in argument space
   Matrix<double> arg_eigv;
   std::string ofilename;
+/// Are we updating the average and covariance as the frames are collected
+  bool online;
+/// Are we combining the average and covariance from multiple replicas
+  bool walkers_mpi;
+/// The frame the atoms are aligned to when we are updating the covariance online
+  ReferenceConfiguration* firstframe;
+/// The sum of the weights, the largest log weight and the average and covariance (times the sum of the weights) of the frames
+  double wsum, maxlogw;
+  std::vector<double> mean, covsum;
+/// Add the current frame to the average and covariance
+  void updateCovariance();
+/// Combine the average and covariance from all the processes and replicas and output the principal components
+  void outputOnlineComponents();
+/// Diagonalize the covariance and print the principal components
+  void printComponents( const std::vector<double>& sarg, const std::vector<Vector>& spos, Matrix<double>& covar );
 public:
   static void registerKeywords( Keywords& keys );
   explicit PCA(const ActionOptions&ao);
   ~PCA();
   void performAnalysis();
+  void performOperations( const bool& from_update );
+  void runFinalJobs();
   void performTask( const unsigned&, const unsigned&, MultiValue& ) const { plumed_error(); }
 };
 
@@ -116,10 +146,17 @@ void PCA::registerKeywords( Keywords& keys ) {
   Analysis::registerKeywords( keys );
   keys.add("compulsory","NLOW_DIM","number of PCA coordinates required");
   keys.add("compulsory","OFILE","the file on which to output the eigenvectors");
+  keys.addFlag("ONLINE",false,"update the average and covariance every time a frame is collected rather than storing the frames");
+  keys.addFlag("WALKERS_MPI",false,"combine the average and covariance that are calculated online by all the replicas");
 }
 
 PCA::PCA(const ActionOptions&ao):
-  PLUMED_ANALYSIS_INIT(ao)
+  PLUMED_ANALYSIS_INIT(ao),
+  online(false),
+  walkers_mpi(false),
+  firstframe(NULL),
+  wsum(0),
+  maxlogw(0)
 {
   // Setup reference configuration
   log.printf("  performing PCA analysis using %s metric \n", getMetricName().c_str() );
@@ -137,11 +174,135 @@ PCA::PCA(const ActionOptions&ao):
 
   // Read stuff for output file
   parseOutputFile("OFILE",ofilename);
+  parseFlag("ONLINE",online);
+  parseFlag("WALKERS_MPI",walkers_mpi);
+  if( walkers_mpi && !online ) error("WALKERS_MPI can only be used with ONLINE");
+  if( online ) {
+    doNotStoreData();
+    unsigned nvals=getNumberOfArguments()+3*getNumberOfAtoms();
+    mean.resize( nvals, 0.0 ); covsum.resize( nvals*nvals, 0.0 );
+    log.printf("  updating average and covariance every time a frame is collected\n");
+    if( walkers_mpi ) log.printf("  combining average and covariance from all replicas\n");
+  }
   checkRead();
 }
 
 PCA::~PCA() {
   delete myref;
+  delete firstframe;
+}
+
+void PCA::performOperations( const bool& from_update ) {
+  if( !online ) { Analysis::performOperations( from_update ); return; }
+  // Don't use the first step as is done when the frames are stored
+  if( getStep()==0 ) return;
+  updateCovariance();
+  unsigned freq=getRunFrequency();
+  if( freq>0 && getStep()%freq==0 ) outputOnlineComponents();
+}
+
+void PCA::runFinalJobs() {
+  if( !online ) { Analysis::runFinalJobs(); return; }
+  if( getRunFrequency()>0 ) return;
+  if( wsum==0 ) error("no data is available for analysis");
+  outputOnlineComponents();
+}
+
+void PCA::updateCovariance() {
+  unsigned narg=getNumberOfArguments();
+  std::vector<double> args( narg );
+  for(unsigned i=0; i<narg; ++i) args[i]=getArgument(i);
+  MultiValue myval( 1, narg + 3*getNumberOfAtoms() + 9 );
+  ReferenceValuePack mypack( narg, getNumberOfAtoms(), myval );
+  for(unsigned i=0; i<getNumberOfAtoms(); ++i) mypack.setAtomIndex( i, i );
+
+  if( !firstframe ) {
+    // All the replicas align to the first frame from the first replica
+    std::vector<Vector> pos( getPositions() );
+    if( walkers_mpi ) {
+      if( comm.Get_rank()==0 ) {
+        if( pos.size()>0 ) multi_sim_comm.Bcast( &pos[0][0], 3*pos.size(), 0 );
+        if( narg>0 ) multi_sim_comm.Bcast( &args[0], narg, 0 );
+      }
+      if( pos.size()>0 ) comm.Bcast( &pos[0][0], 3*pos.size(), 0 );
+      if( narg>0 ) comm.Bcast( &args[0], narg, 0 );
+    }
+    firstframe = metricRegister().create<ReferenceConfiguration>( getMetricName() );
+    firstframe->setNamesAndAtomNumbers( getAbsoluteIndexes(), argument_names );
+    std::vector<double> metric; if( getMetricName()=="EUCLIDEAN" ) metric.resize( narg, 1.0 );
+    firstframe->setReferenceConfig( pos, args, metric );
+    firstframe->setupPCAStorage( mypack );
+    maxlogw=lweight;
+    for(unsigned i=0; i<narg; ++i) args[i]=getArgument(i);
+  } else firstframe->setupPCAStorage( mypack );
+
+  // Get the displacement from the first frame
+  firstframe->calc( getPositions(), getPbc(), getArguments(), args, mypack, true );
+  std::vector<double> frame( mean.size() );
+  for(unsigned j=0; j<narg; ++j) frame[j] = 0.5*mypack.getArgumentDerivative(j) + firstframe->getReferenceArguments()[j];
+  if( getNumberOfAtoms()>0 ) {
+    const std::vector<double>& displace( dynamic_cast<ReferenceAtoms*>( firstframe )->getDisplace() );
+    for(unsigned j=0; j<getNumberOfAtoms(); ++j) {
+      for(unsigned k=0; k<3; ++k) frame[narg+3*j+k] = mypack.getAtomsDisplacementVector()[j][k] / displace[j] + firstframe->getReferencePositions()[j][k];
+    }
+  }
+
+  // The weights are stored relative to the largest weight so they do not overflow
+  if( lweight>maxlogw ) {
+    double scale=exp( maxlogw-lweight ); wsum*=scale;
+    for(unsigned i=0; i<covsum.size(); ++i) covsum[i]*=scale;
+    maxlogw=lweight;
+  }
+  double w=exp( lweight-maxlogw ), oldwsum=wsum; wsum+=w;
+  std::vector<double> delta( mean.size() );
+  for(unsigned j=0; j<mean.size(); ++j) { delta[j]=frame[j]-mean[j]; mean[j]+=(w/wsum)*delta[j]; }
+  // Each process updates a subset of the rows of the upper triangle of the covariance
+  double pref=w*oldwsum/wsum; unsigned nvals=mean.size();
+  unsigned stride=comm.Get_size(), rank=comm.Get_rank();
+  for(unsigned j=rank; j<nvals; j+=stride) {
+    double pdelta=pref*delta[j];
+    for(unsigned k=j; k<nvals; ++k) covsum[j*nvals+k] += pdelta*delta[k];
+  }
+}
+
+void PCA::outputOnlineComponents() {
+  unsigned nvals=mean.size();
+  Matrix<double> covar( nvals, nvals ); covar=covsum;
+  comm.Sum( covar );
+  double W=wsum; std::vector<double> gmean( mean );
+  if( walkers_mpi ) {
+    // Combine the sums from each replica using the same reference for the weights
+    double gmaxlogw=maxlogw;
+    if( comm.Get_rank()==0 ) multi_sim_comm.Max( gmaxlogw );
+    comm.Bcast( gmaxlogw, 0 );
+    double scale=exp( maxlogw-gmaxlogw ); W*=scale; covar*=scale;
+    for(unsigned j=0; j<nvals; ++j) gmean[j]*=W;
+    double gW=W;
+    if( comm.Get_rank()==0 ) { multi_sim_comm.Sum( gW ); multi_sim_comm.Sum( gmean ); }
+    comm.Bcast( gW, 0 ); comm.Bcast( gmean, 0 );
+    for(unsigned j=0; j<nvals; ++j) gmean[j]/=gW;
+    // Add the contribution from the difference between the average of this replica and the overall average
+    for(unsigned j=0; j<nvals; ++j) {
+      for(unsigned k=j; k<nvals; ++k) covar(j,k) += W*(mean[j]-gmean[j])*(mean[k]-gmean[k]);
+    }
+    if( comm.Get_rank()==0 ) multi_sim_comm.Sum( covar );
+    comm.Bcast( covar, 0 );
+    W=gW;
+  }
+  // Normalize and fill in the lower triangle.  The blocks and scaling are the same as when the frames are stored
+  unsigned narg=getNumberOfArguments();
+  for(unsigned j=0; j<nvals; ++j) {
+    for(unsigned k=j; k<nvals; ++k) {
+      if( j<narg && k>=narg ) covar(j,k)=0;
+      else if( k<narg ) covar(j,k)*=0.25/W;
+      else covar(j,k)/=W;
+      covar(k,j)=covar(j,k);
+    }
+  }
+  std::vector<double> sarg( narg ); std::vector<Vector> spos( getNumberOfAtoms() );
+  for(unsigned j=0; j<narg; ++j) sarg[j]=gmean[j];
+  for(unsigned j=0; j<getNumberOfAtoms(); ++j) spos[j]=Vector( gmean[narg+3*j], gmean[narg+3*j+1], gmean[narg+3*j+2] );
+  printComponents( sarg, spos, covar );
 }
 
 void PCA::performAnalysis() {
@@ -150,9 +311,9 @@ void PCA::performAnalysis() {
   ReferenceValuePack mypack( getNumberOfArguments(), getNumberOfAtoms(), myval );
   for(unsigned i=0; i<getNumberOfAtoms(); ++i) mypack.setAtomIndex( i, i );
   // Setup some PCA storage
-  data[0]->setupPCAStorage ( mypack ); std::vector<double> displace( getNumberOfAtoms() );
+  getStoredConfiguration(0)->setupPCAStorage ( mypack ); std::vector<double> displace( getNumberOfAtoms() );
   if( getNumberOfAtoms()>0 ) {
-    ReferenceAtoms* at = dynamic_cast<ReferenceAtoms*>( data[0] );
+    ReferenceAtoms* at = dynamic_cast<ReferenceAtoms*>( getStoredConfiguration(0) );
     displace = at->getDisplace();
   }
 
@@ -164,7 +325,9 @@ void PCA::performAnalysis() {
   // Calculate the average displacement from the first frame
   double norm=getWeight(0);
   for(unsigned i=1; i<getNumberOfDataPoints(); ++i) {
-    double d = data[0]->calc( data[i]->getReferencePositions(), getPbc(), getArguments(), data[i]->getReferenceArguments(), mypack, true );
+    // The first frame must be retrieved first so that it stays in memory when the data is on disk
+    ReferenceConfiguration* ref=getStoredConfiguration(0); ReferenceConfiguration* conf=getStoredConfiguration(i);
+    double d = ref->calc( conf->getReferencePositions(), getPbc(), getArguments(), conf->getReferenceArguments(), mypack, true );
     // Accumulate average displacement of arguments (Here PBC could do fucked up things - really needs Berry Phase ) GAT
     for(unsigned j=0; j<getNumberOfArguments(); ++j) sarg[j] += 0.5*getWeight(i)*mypack.getArgumentDerivative(j);
     // Accumulate average displacement of position
@@ -173,32 +336,32 @@ void PCA::performAnalysis() {
   }
   // Now normalise the displacements to get the average and add these to the first frame
   double inorm = 1.0 / norm ;
-  for(unsigned j=0; j<getNumberOfArguments(); ++j) sarg[j] = inorm*sarg[j] + data[0]->getReferenceArguments()[j];
-  for(unsigned j=0; j<getNumberOfAtoms(); ++j) spos[j] = inorm*spos[j] + data[0]->getReferencePositions()[j];
-  // And set the reference configuration
-  std::vector<double> empty( getNumberOfArguments(), 1.0 ); myref->setReferenceConfig( spos, sarg, empty );
+  ReferenceConfiguration* first=getStoredConfiguration(0);
+  for(unsigned j=0; j<getNumberOfArguments(); ++j) sarg[j] = inorm*sarg[j] + first->getReferenceArguments()[j];
+  for(unsigned j=0; j<getNumberOfAtoms(); ++j) spos[j] = inorm*spos[j] + first->getReferencePositions()[j];
 
   // Now accumulate the covariance
   unsigned narg=getNumberOfArguments();
   Matrix<double> covar( getNumberOfArguments()+3*getNumberOfAtoms(), getNumberOfArguments()+3*getNumberOfAtoms() ); covar=0;
   for(unsigned i=0; i<getNumberOfDataPoints(); ++i) {
     // double d = data[i]->calc( spos, getPbc(), getArguments(), sarg, mypack, true );
-    double d = data[0]->calc( data[i]->getReferencePositions(), getPbc(), getArguments(), data[i]->getReferenceArguments(), mypack, true );
+    ReferenceConfiguration* ref=getStoredConfiguration(0); ReferenceConfiguration* conf=getStoredConfiguration(i);
+    double d = ref->calc( conf->getReferencePositions(), getPbc(), getArguments(), conf->getReferenceArguments(), mypack, true );
     for(unsigned jarg=0; jarg<getNumberOfArguments(); ++jarg) {
       // Need sorting for PBC with GAT
-      double jarg_d = 0.5*mypack.getArgumentDerivative(jarg) + data[0]->getReferenceArguments()[jarg] - sarg[jarg];
+      double jarg_d = 0.5*mypack.getArgumentDerivative(jarg) + ref->getReferenceArguments()[jarg] - sarg[jarg];
       for(unsigned karg=0; karg<getNumberOfArguments(); ++karg) {
         // Need sorting for PBC with GAT
-        double karg_d = 0.5*mypack.getArgumentDerivative(karg) + data[0]->getReferenceArguments()[karg] - sarg[karg];
+        double karg_d = 0.5*mypack.getArgumentDerivative(karg) + ref->getReferenceArguments()[karg] - sarg[karg];
         covar( jarg, karg ) += 0.25*getWeight(i)*jarg_d*karg_d; // mypack.getArgumentDerivative(jarg)*mypack.getArgumentDerivative(karg);
       }
     }
     for(unsigned jat=0; jat<getNumberOfAtoms(); ++jat) {
       for(unsigned jc=0; jc<3; ++jc) {
-        double jdisplace = mypack.getAtomsDisplacementVector()[jat][jc] / displace[jat] + data[0]->getReferencePositions()[jat][jc] - spos[jat][jc];
+        double jdisplace = mypack.getAtomsDisplacementVector()[jat][jc] / displace[jat] + ref->getReferencePositions()[jat][jc] - spos[jat][jc];
         for(unsigned kat=0; kat<getNumberOfAtoms(); ++kat) {
           for(unsigned kc=0; kc<3; ++kc) {
-            double kdisplace = mypack.getAtomsDisplacementVector()[kat][kc] / displace[kat] + data[0]->getReferencePositions()[kat][kc] - spos[kat][kc];
+            double kdisplace = mypack.getAtomsDisplacementVector()[kat][kc] / displace[kat] + ref->getReferencePositions()[kat][kc] - spos[kat][kc];
             covar( narg+3*jat + jc, narg+3*kat + kc ) += getWeight(i)*jdisplace*kdisplace;
           }
         }
@@ -209,6 +372,13 @@ void PCA::performAnalysis() {
   for(unsigned i=0; i<covar.nrows(); ++i) {
     for(unsigned j=0; j<covar.ncols(); ++j) covar(i,j) *= inorm;
   }
+  printComponents( sarg, spos, covar );
+}
+
+void PCA::printComponents( const std::vector<double>& sarg, const std::vector<Vector>& spos, Matrix<double>& covar ) {
+  // Set the reference configuration
+  unsigned narg=getNumberOfArguments();
+  std::vector<double> empty( getNumberOfArguments(), 1.0 ); myref->setReferenceConfig( spos, sarg, empty );
 
   // Diagonalise the covariance
   std::vector<double> eigval( getNumberOfArguments()+3*getNumberOfAtoms() );
@@ -70,14 +70,10 @@ void Bias::apply() {
 
   // additional forces on the bias component
   std::vector<double> f(noa,0.0);
-  std::vector<double> forces(noa);
 
   bool at_least_one_forced=false;
   for(unsigned i=0; i<ncp; ++i) {
-    if(getPntrToComponent(i)->applyForce(forces)) {
-      at_least_one_forced=true;
-      for(unsigned j=0; j<noa; j++) f[j]+=forces[j];
-    }
+    if(getPntrToComponent(i)->accumulateForces(f)) at_least_one_forced=true;
   }
 
   if(at_least_one_forced && !onStep()) error("you are biasing a bias with an inconsistent STRIDE");
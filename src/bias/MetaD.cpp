@@ -29,6 +29,9 @@
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
 #include "tools/Random.h"
+#include "tools/OpenMP.h"
+#include "tools/HashedBins.h"
+#include "tools/KernelFunctions.h"
 #include <string>
 #include <cstring>
 #include "tools/File.h"
@@ -341,10 +344,24 @@ private:
     double height;
     bool   multivariate; // this is required to discriminate the one dimensional case
     vector<double> invsigma;
+    // full inverse covariance matrix of multivariate hills, stored by rows
+    vector<double> metric;
     Gaussian(const vector<double> & center,const vector<double> & sigma,double height, bool multivariate ):
       center(center),sigma(sigma),height(height),multivariate(multivariate),invsigma(sigma) {
       // to avoid troubles from zero element in flexible hills
       for(unsigned i=0; i<invsigma.size(); ++i) abs(invsigma[i])>1.e-20?invsigma[i]=1.0/invsigma[i]:0.;
+      if(multivariate) {
+        // recompose the full inverse matrix from the upper diagonal part
+        unsigned ncv=center.size();
+        metric.resize(ncv*ncv);
+        unsigned k=0;
+        for(unsigned i=0; i<ncv; i++) {
+          for(unsigned j=i; j<ncv; j++) {
+            metric[i*ncv+j]=metric[j*ncv+i]=sigma[k];
+            k++;
+          }
+        }
+      }
     }
   };
   struct TemperingSpecs {
@@ -362,9 +379,12 @@ private:
   vector<double> sigma0min_;
   vector<double> sigma0max_;
   vector<Gaussian> hills_;
+// index of the hills, used to find the hills that contribute at a given point when there is no grid
+  HashedBins* hillbins_;
   OFile hillsOfile_;
   OFile gridfile_;
   Grid* BiasGrid_;
+  bool sparsegrid_;
   bool storeOldGrids_;
   int wgridstride_;
   bool grid_;
@@ -413,15 +433,18 @@ private:
   void   readTemperingSpecs(TemperingSpecs &t_specs);
   void   logTemperingSpecs(const TemperingSpecs &t_specs);
   void   readGaussians(IFile*);
-  bool   readChunkOfGaussians(IFile *ifile, unsigned n);
+  unsigned readChunkOfGaussians(IFile *ifile, unsigned n);
   void   writeGaussian(const Gaussian&,OFile&);
   void   addGaussian(const Gaussian&);
+  void   addGaussians(const vector<Gaussian>&);
   double getHeight(const vector<double>&);
   void   temperHeight(double &height, const TemperingSpecs &t_specs, const double tempering_bias);
   double getBiasAndDerivatives(const vector<double>&,double* der=NULL);
   double evaluateGaussian(const vector<double>&, const Gaussian&,double* der=NULL);
+  double evaluateGaussian(const double* cv, const Gaussian&, double* der, double* dp) const;
   double getGaussianNormalization( const Gaussian& );
   vector<unsigned> getGaussianSupport(const Gaussian&);
+  vector<double> getGaussianBox(const Gaussian&);
   bool   scanOneHill(IFile *ifile,  vector<Value> &v, vector<double> &center, vector<double>  &sigma, double &height, bool &multivariate);
   void   computeReweightingFactor();
   double getTransitionBarrierBias();
@@ -507,6 +530,7 @@ void MetaD::registerTemperingKeywords(const std::string &name_stem, const std::s
 
 MetaD::~MetaD() {
   if(flexbin) delete flexbin;
+  if(hillbins_) delete hillbins_;
   if(BiasGrid_) delete BiasGrid_;
   if(TargetGrid_) delete TargetGrid_;
   hillsOfile_.close();
@@ -522,7 +546,8 @@ MetaD::~MetaD() {
 MetaD::MetaD(const ActionOptions& ao):
   PLUMED_BIAS_INIT(ao),
 // Grid stuff initialization
-  BiasGrid_(NULL), wgridstride_(0), grid_(false),
+  hillbins_(NULL),
+  BiasGrid_(NULL), sparsegrid_(false), wgridstride_(0), grid_(false),
 // Metadynamics basic parameters
   height0_(std::numeric_limits<double>::max()), biasf_(-1.0), dampfactor_(0.0),
   tt_specs_(false, "TT", "Transition Tempered", -1.0, 0.0, 1.0),
@@ -719,8 +744,7 @@ MetaD::MetaD(const ActionOptions& ao):
         if(gbin[i]<n) gbin[i]=n;
       }
   }
-  bool sparsegrid=false;
-  parseFlag("GRID_SPARSE",sparsegrid);
+  parseFlag("GRID_SPARSE",sparsegrid_);
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -871,7 +895,7 @@ MetaD::MetaD(const ActionOptions& ao):
     for(unsigned i=0; i<gbin.size(); ++i) log.printf(" %u",gbin[i]);
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
-    if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(sparsegrid_) {log.printf("  Grid uses sparse grid\n");}
     if(wgridstride_>0) {log.printf("  Grid is written on file %s with stride %d\n",gridfilename_.c_str(),wgridstride_);}
   }
 
@@ -993,7 +1017,7 @@ MetaD::MetaD(const ActionOptions& ao):
       }
     }
     std::string funcl=getLabel() + ".bias";
-    if(!sparsegrid) {BiasGrid_=new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
+    if(!sparsegrid_) {BiasGrid_=new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
     else {BiasGrid_=new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
     std::vector<std::string> actualmin=BiasGrid_->getMin();
     std::vector<std::string> actualmax=BiasGrid_->getMax();
@@ -1015,7 +1039,7 @@ MetaD::MetaD(const ActionOptions& ao):
       error("The GRID file you want to read: " + gridreadfilename_ + ", cannot be found!");
     }
     std::string funcl=getLabel() + ".bias";
-    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
+    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid_, spline, true);
     gridfile.close();
     if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
     for(unsigned i=0; i<getNumberOfArguments(); ++i) {
@@ -1043,7 +1067,7 @@ MetaD::MetaD(const ActionOptions& ao):
       if(mesh>0.5*sigma0_[i]) log<<"  WARNING: Using a METAD with a Grid Spacing larger than half of the Gaussians width can produce artifacts\n";
     }
     std::string funcl=getLabel() + ".bias";
-    if(!sparsegrid) {BiasGrid_=new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
+    if(!sparsegrid_) {BiasGrid_=new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
     else {BiasGrid_=new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
     std::vector<std::string> actualmin=BiasGrid_->getMin();
     std::vector<std::string> actualmax=BiasGrid_->getMax();
@@ -1229,50 +1253,35 @@ void MetaD::logTemperingSpecs(const TemperingSpecs &t_specs) {
 
 void MetaD::readGaussians(IFile *ifile)
 {
-  unsigned ncv=getNumberOfArguments();
-  vector<double> center(ncv);
-  vector<double> sigma(ncv);
-  double height;
-  int nhills=0;
-  bool multivariate=false;
-
-  std::vector<Value> tmpvalues;
-  for(unsigned j=0; j<getNumberOfArguments(); ++j) tmpvalues.push_back( Value( this, getPntrToArgument(j)->getName(), false ) );
-
-  while(scanOneHill(ifile,tmpvalues,center,sigma,height,multivariate)) {
-    ;
-    nhills++;
-// note that for gamma=1 we store directly -F
-    if(welltemp_ && biasf_>1.0) {height*=(biasf_-1.0)/biasf_;}
-    addGaussian(Gaussian(center,sigma,height,multivariate));
+// hills are read in chunks, each chunk being added to the bias at once
+  const unsigned chunk=100;
+  unsigned nhills=0;
+  while(true) {
+    unsigned n=readChunkOfGaussians(ifile,chunk);
+    nhills+=n;
+    if(n<chunk) break;
   }
-  log.printf("      %d Gaussians read\n",nhills);
+  log.printf("      %u Gaussians read\n",nhills);
 }
 
-bool MetaD::readChunkOfGaussians(IFile *ifile, unsigned n)
+unsigned MetaD::readChunkOfGaussians(IFile *ifile, unsigned n)
 {
   unsigned ncv=getNumberOfArguments();
   vector<double> center(ncv);
   vector<double> sigma(ncv);
   double height;
-  unsigned nhills=0;
   bool multivariate=false;
   std::vector<Value> tmpvalues;
   for(unsigned j=0; j<getNumberOfArguments(); ++j) tmpvalues.push_back( Value( this, getPntrToArgument(j)->getName(), false ) );
 
-  while(scanOneHill(ifile,tmpvalues,center,sigma,height,multivariate)) {
-    ;
+  vector<Gaussian> newhills;
+  while(newhills.size()<n && scanOneHill(ifile,tmpvalues,center,sigma,height,multivariate)) {
 // note that for gamma=1 we store directly -F
     if(welltemp_ && biasf_>1.0) height*=(biasf_-1.0)/biasf_;
-    addGaussian(Gaussian(center,sigma,height,multivariate));
-    if(nhills==n) {
-      log.printf("      %u Gaussians read\n",nhills);
-      return true;
-    }
-    nhills++;
+    newhills.push_back(Gaussian(center,sigma,height,multivariate));
   }
-  log.printf("      %u Gaussians read\n",nhills);
-  return false;
+  if(!newhills.empty()) addGaussians(newhills);
+  return newhills.size();
 }
 
 void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
@@ -1327,42 +1336,183 @@ void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
 
 void MetaD::addGaussian(const Gaussian& hill)
 {
-  if(!grid_) hills_.push_back(hill);
-  else {
-    unsigned ncv=getNumberOfArguments();
+  addGaussians(vector<Gaussian>(1,hill));
+}
+
+void MetaD::addGaussians(const vector<Gaussian>& hills)
+{
+  if(!grid_) {
+    for(unsigned h=0; h<hills.size(); ++h) {
+      vector<double> box=getGaussianBox(hills[h]);
+      if(!hillbins_) {
+        // bins are as large as the support of the first hill, and are enlarged when wider hills are added
+        vector<double> width(box.size());
+        for(unsigned i=0; i<box.size(); ++i) width[i]=2.0*box[i];
+        hillbins_=new HashedBins(width);
+        for(unsigned i=0; i<getNumberOfArguments(); ++i) if(getPntrToArgument(i)->isPeriodic()) {
+            double min,max;
+            getPntrToArgument(i)->getDomain(min,max);
+            hillbins_->setPeriodic(i,min,max);
+          }
+      }
+      hillbins_->add(hills[h].center,box);
+      hills_.push_back(hills[h]);
+    }
+    return;
+  }
+  const unsigned ncv=getNumberOfArguments();
+  const unsigned nhills=hills.size();
+  const vector<unsigned> nbin=BiasGrid_->getNbin();
+  const vector<bool> isperiodic=BiasGrid_->getIsPeriodic();
+// grid points touched by all the hills are stored one after the other,
+// hill h owning the range [offsets[h],offsets[h+1])
+  vector<vector<Grid::index_t> > neighbors(nhills);
+  vector<unsigned> offsets(nhills+1,0);
+// a hill whose support wraps around a periodic grid visits some points twice
+  vector<bool> unique(nhills,true);
+// diagonal hills are the product of one-dimensional gaussians. For these hills
+// the exponential is tabulated along each dimension on the 2k+1 bins of the support:
+// for dimension j, bin (kstart[h][j]+o) is described by the three numbers starting at
+// ktable[h][kfirst[h][j]+3*o], that is exp(-dp^2/2), dp^2/2 and dp, with dp=(x-center)/sigma
+  vector<bool> separable(nhills,false);
+  vector<vector<int> > kstart(nhills);
+  vector<vector<double> > ktable(nhills);
+  vector<vector<unsigned> > kfirst(nhills);
+  for(unsigned h=0; h<nhills; ++h) {
+    const Gaussian & hill(hills[h]);
     vector<unsigned> nneighb=getGaussianSupport(hill);
-    vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(hill.center,nneighb);
-    vector<double> der(ncv);
-    vector<double> xx(ncv);
-    if(comm.Get_size()==1) {
-      for(unsigned i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) der[j]=0.0;
-        BiasGrid_->getPoint(ineigh,xx);
-        double bias=evaluateGaussian(xx,hill,&der[0]);
-        BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
+    neighbors[h]=BiasGrid_->getNeighbors(hill.center,nneighb);
+    offsets[h+1]=offsets[h]+neighbors[h].size();
+    for(unsigned j=0; j<ncv; ++j) if(isperiodic[j] && 2*nneighb[j]+1>nbin[j]) unique[h]=false;
+    separable[h]=(!hill.multivariate && !doInt_ && unique[h]);
+    if(separable[h]) {
+      vector<unsigned> indices=BiasGrid_->getIndices(hill.center);
+      vector<double> xx(ncv);
+      kstart[h].resize(ncv);
+      kfirst[h].resize(ncv);
+      unsigned size=0;
+      for(unsigned j=0; j<ncv; ++j) {
+        kfirst[h][j]=size;
+        size+=3*(2*nneighb[j]+1);
       }
-    } else {
-      unsigned stride=comm.Get_size();
-      unsigned rank=comm.Get_rank();
-      vector<double> allder(ncv*neighbors.size(),0.0);
-      vector<double> allbias(neighbors.size(),0.0);
-      for(unsigned i=rank; i<neighbors.size(); i+=stride) {
-        Grid::index_t ineigh=neighbors[i];
-        BiasGrid_->getPoint(ineigh,xx);
-        allbias[i]=evaluateGaussian(xx,hill,&allder[ncv*i]);
+      ktable[h].assign(size,0.0);
+      for(unsigned j=0; j<ncv; ++j) {
+        const unsigned icenter=indices[j];
+        kstart[h][j]=int(icenter)-int(nneighb[j]);
+        for(unsigned o=0; o<2*nneighb[j]+1; ++o) {
+          int ibin=kstart[h][j]+int(o);
+          if(isperiodic[j]) {
+            ibin%=int(nbin[j]);
+            if(ibin<0) ibin+=nbin[j];
+          } else if(ibin<0 || ibin>=int(nbin[j])) continue;
+          indices[j]=ibin;
+          BiasGrid_->getPoint(indices,xx);
+          double* t=&ktable[h][kfirst[h][j]+3*o];
+          t[2]=difference(j,hill.center[j],xx[j])*hill.invsigma[j];
+          t[1]=0.5*t[2]*t[2];
+          t[0]=exp(-t[1]);
+        }
+        indices[j]=icenter;
       }
-      comm.Sum(allbias);
-      comm.Sum(allder);
-      for(unsigned i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) {der[j]=allder[ncv*i+j];}
-        BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+    }
+  }
+  const unsigned ntot=offsets[nhills];
+
+  const unsigned stride=comm.Get_size();
+  const unsigned rank=comm.Get_rank();
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*stride*10>ntot) nt=ntot/stride/10;
+  if(nt==0) nt=1;
+
+  vector<double> allder(ncv*ntot,0.0);
+  vector<double> allbias(ntot,0.0);
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<unsigned> indices(ncv);
+    vector<double> xx(ncv);
+    vector<double> dp(ncv);
+    for(unsigned h=0; h<nhills; ++h) {
+      const unsigned nn=neighbors[h].size();
+      if(separable[h]) {
+        const Gaussian & hill(hills[h]);
+        #pragma omp for nowait
+        for(unsigned i=rank; i<nn; i+=stride) {
+          const unsigned k=offsets[h]+i;
+          BiasGrid_->getIndices(neighbors[h][i],indices);
+          // outer product of the one-dimensional tables
+          double dp2=0.0;
+          double bias=hill.height;
+          for(unsigned j=0; j<ncv; ++j) {
+            int o=int(indices[j])-kstart[h][j];
+            if(isperiodic[j]) {
+              o%=int(nbin[j]);
+              if(o<0) o+=nbin[j];
+            }
+            const double* t=&ktable[h][kfirst[h][j]+3*o];
+            bias*=t[0];
+            dp2+=t[1];
+            dp[j]=t[2];
+          }
+          if(dp2<DP2CUTOFF) {
+            allbias[k]=bias;
+            for(unsigned j=0; j<ncv; ++j) allder[ncv*k+j]=-bias*dp[j]*hill.invsigma[j];
+          }
+        }
+      } else {
+        #pragma omp for nowait
+        for(unsigned i=rank; i<nn; i+=stride) {
+          const unsigned k=offsets[h]+i;
+          BiasGrid_->getIndices(neighbors[h][i],indices);
+          BiasGrid_->getPoint(indices,xx);
+          allbias[k]=evaluateGaussian(&xx[0],hills[h],&allder[ncv*k],&dp[0]);
+        }
+      }
+    }
+  }
+// a single reduction for all the hills
+  if(stride>1) {
+    comm.Sum(allbias);
+    comm.Sum(allder);
+  }
+
+// hills are added one after the other so that the result does not depend on the number of threads
+  for(unsigned h=0; h<nhills; ++h) {
+    const unsigned nn=neighbors[h].size();
+    unsigned ntadd=(unique[h] && !sparsegrid_) ? nt : 1;
+    if(ntadd*10>nn) ntadd=nn/10;
+    if(ntadd==0) ntadd=1;
+    #pragma omp parallel num_threads(ntadd)
+    {
+      vector<double> der(ncv);
+      #pragma omp for
+      for(unsigned i=0; i<nn; ++i) {
+        const unsigned k=offsets[h]+i;
+        for(unsigned j=0; j<ncv; ++j) der[j]=allder[ncv*k+j];
+        BiasGrid_->addValueAndDerivatives(neighbors[h][i],allbias[k],der);
       }
     }
   }
 }
 
+vector<double> MetaD::getGaussianBox(const Gaussian& hill)
+{
+  unsigned ncv=getNumberOfArguments();
+  vector<double> box(ncv);
+  if(hill.multivariate) {
+    // the hill is cut on an ellipsoid, find the box containing it
+    Matrix<double> mymatrix(ncv,ncv);
+    for(unsigned i=0; i<ncv; i++) for(unsigned j=0; j<ncv; j++) mymatrix(i,j)=hill.metric[i*ncv+j];
+    Matrix<double> myinv(ncv,ncv);
+    Invert(mymatrix,myinv);
+    for(unsigned i=0; i<ncv; i++) box[i]=sqrt(2.0*DP2CUTOFF*myinv(i,i));
+  } else {
+    for(unsigned i=0; i<ncv; i++) box[i]=sqrt(2.0*DP2CUTOFF)*hill.sigma[i];
+  }
+  // slightly enlarge the box so as to be safe against rounding errors
+  for(unsigned i=0; i<ncv; i++) box[i]*=1.0+1e-6;
+  return box;
+}
+
 vector<unsigned> MetaD::getGaussianSupport(const Gaussian& hill)
 {
   vector<unsigned> nneigh;
@@ -1430,8 +1580,15 @@ double MetaD::getBiasAndDerivatives(const vector<double>& cv, double* der)
     }
     unsigned stride=comm.Get_size();
     unsigned rank=comm.Get_rank();
-    for(unsigned i=rank; i<hills_.size(); i+=stride) {
-      bias+=evaluateGaussian(cv,hills_[i],der);
+    if(hillbins_) {
+      // only hills whose support contains cv are evaluated
+      // with INTERVAL, hills are evaluated at the closest boundary
+      vector<double> x(cv);
+      if(doInt_) x[0]=std::max(lowI_,std::min(uppI_,x[0]));
+      const vector<unsigned> & close(hillbins_->get(x));
+      for(unsigned i=rank; i<close.size(); i+=stride) {
+        bias+=evaluateGaussian(cv,hills_[close[i]],der);
+      }
     }
     comm.Sum(bias);
     if(der) comm.Sum(der,getNumberOfArguments());
@@ -1474,73 +1631,52 @@ double MetaD::getGaussianNormalization( const Gaussian& hill )
 
 double MetaD::evaluateGaussian(const vector<double>& cv, const Gaussian& hill, double* der)
 {
+  plumed_dbg_assert(cv.size()==hill.center.size());
+  if(cv.size()==0) return 0.0;
+  return evaluateGaussian(&cv[0],hill,der,dp_);
+}
+
+double MetaD::evaluateGaussian(const double* cv, const Gaussian& hill, double* der, double* dp) const
+{
+  const unsigned ncv=hill.center.size();
   double dp2=0.0;
   double bias=0.0;
   // I use a pointer here because cv is const (and should be const)
   // but when using doInt it is easier to locally replace cv[0] with
   // the upper/lower limit in case it is out of range
-  const double *pcv=NULL; // pointer to cv
+  const double *pcv=cv; // pointer to cv
   double tmpcv[1]; // tmp array with cv (to be used with doInt_)
-  if(cv.size()>0) pcv=&cv[0];
   if(doInt_) {
-    plumed_assert(cv.size()==1);
+    plumed_assert(ncv==1);
     tmpcv[0]=cv[0];
     if(cv[0]<lowI_) tmpcv[0]=lowI_;
     if(cv[0]>uppI_) tmpcv[0]=uppI_;
     pcv=&(tmpcv[0]);
   }
   if(hill.multivariate) {
-    unsigned k=0;
-    unsigned ncv=cv.size();
-    // recompose the full sigma from the upper diag cholesky
-    Matrix<double> mymatrix(ncv,ncv);
-    for(unsigned i=0; i<ncv; i++) {
-      for(unsigned j=i; j<ncv; j++) {
-        mymatrix(i,j)=mymatrix(j,i)=hill.sigma[k]; // recompose the full inverse matrix
-        k++;
-      }
-    }
-    for(unsigned i=0; i<cv.size(); ++i) {
-      double dp_i=difference(i,hill.center[i],pcv[i]);
-      dp_[i]=dp_i;
-      for(unsigned j=i; j<cv.size(); ++j) {
-        if(i==j) {
-          dp2+=dp_i*dp_i*mymatrix(i,j)*0.5;
-        } else {
-          double dp_j=difference(j,hill.center[j],pcv[j]);
-          dp2+=dp_i*dp_j*mymatrix(i,j);
-        }
-      }
-    }
+    const double* metric=&hill.metric[0];
+    for(unsigned i=0; i<ncv; ++i) dp[i]=difference(i,hill.center[i],pcv[i]);
+    dp2=KernelFunctions::halfMetricNorm2(ncv,metric,dp,NULL);
     if(dp2<DP2CUTOFF) {
       bias=hill.height*exp(-dp2);
-      if(der) {
-        for(unsigned i=0; i<cv.size(); ++i) {
+      if(der) for(unsigned i=0; i<ncv; ++i) {
           double tmp=0.0;
-          for(unsigned j=0; j<cv.size(); ++j) {
-            tmp += dp_[j]*mymatrix(i,j)*bias;
-          }
+          for(unsigned j=0; j<ncv; ++j) tmp += dp[j]*metric[i*ncv+j]*bias;
           der[i]-=tmp;
         }
-      }
     }
   } else {
-    for(unsigned i=0; i<cv.size(); ++i) {
-      double dp=difference(i,hill.center[i],pcv[i])*hill.invsigma[i];
-      dp2+=dp*dp;
-      dp_[i]=dp;
-    }
-    dp2*=0.5;
+    for(unsigned i=0; i<ncv; ++i) dp[i]=difference(i,hill.center[i],pcv[i]);
+// after this call dp contains the gradient of dp2
+    dp2=KernelFunctions::halfDiagonalNorm2(ncv,&hill.invsigma[0],dp,dp);
     if(dp2<DP2CUTOFF) {
       bias=hill.height*exp(-dp2);
-      if(der) {
-        for(unsigned i=0; i<cv.size(); ++i) {der[i]+=-bias*dp_[i]*hill.invsigma[i];}
-      }
+      if(der) for(unsigned i=0; i<ncv; ++i) der[i]+=-bias*dp[i];
     }
   }
 
   if(doInt_ && der) {
-    if(cv[0]<lowI_ || cv[0]>uppI_) for(unsigned i=0; i<cv.size(); ++i) der[i]=0;
+    if(cv[0]<lowI_ || cv[0]>uppI_) for(unsigned i=0; i<ncv; ++i) der[i]=0;
   }
 
   return bias;
@@ -1674,17 +1810,19 @@ void MetaD::update() {
       comm.Bcast(all_sigma,0);
       comm.Bcast(all_height,0);
       comm.Bcast(all_multivariate,0);
+      std::vector<Gaussian> newhills;
+      newhills.reserve(mpi_nw_);
       for(unsigned i=0; i<mpi_nw_; i++) {
-        // actually add hills one by one
         std::vector<double> cv_now(cv.size());
         std::vector<double> sigma_now(thissigma.size());
         for(unsigned j=0; j<cv.size(); j++) cv_now[j]=all_cv[i*cv.size()+j];
         for(unsigned j=0; j<thissigma.size(); j++) sigma_now[j]=all_sigma[i*thissigma.size()+j];
 // notice that if gamma=1 we store directly -F so this scaling is not necessary:
-        Gaussian newhill=Gaussian(cv_now,sigma_now,all_height[i]*(biasf_>1.0?(biasf_-1.0)/biasf_:1.0),all_multivariate[i]);
-        addGaussian(newhill);
-        writeGaussian(newhill,hillsOfile_);
+        newhills.push_back(Gaussian(cv_now,sigma_now,all_height[i]*(biasf_>1.0?(biasf_-1.0)/biasf_:1.0),all_multivariate[i]));
       }
+      // hills from all the walkers are added at once
+      addGaussians(newhills);
+      for(unsigned i=0; i<mpi_nw_; i++) writeGaussian(newhills[i],hillsOfile_);
     } else {
       Gaussian newhill=Gaussian(cv,thissigma,height,multivariate);
       addGaussian(newhill);
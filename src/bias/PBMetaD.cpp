@@ -29,6 +29,7 @@
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
 #include "tools/Random.h"
+#include "tools/HashedBins.h"
 #include <string>
 #include <cstring>
 #include "tools/File.h"
@@ -234,6 +235,8 @@ private:
   vector<double> sigma0min_;
   vector<double> sigma0max_;
   vector< vector<Gaussian> > hills_;
+// index of the hills of each bias, used to find the hills that contribute at a given point when there is no grid
+  vector<HashedBins*> hillbins_;
   vector<OFile*> hillsOfiles_;
   vector<OFile*> gridfiles_;
   vector<Grid*> BiasGrids_;
@@ -268,6 +271,7 @@ private:
   double getBiasAndDerivatives(unsigned iarg, const vector<double>&, double* der=NULL);
   double evaluateGaussian(unsigned iarg, const vector<double>&, const Gaussian&,double* der=NULL);
   vector<unsigned> getGaussianSupport(unsigned iarg, const Gaussian&);
+  double getGaussianCutoff(const Gaussian&);
   bool   scanOneHill(unsigned iarg, IFile *ifile,  vector<Value> &v, vector<double> &center, vector<double>  &sigma, double &height, bool &multivariate);
   std::string fmt;
 
@@ -319,6 +323,7 @@ void PBMetaD::registerKeywords(Keywords& keys) {
 
 PBMetaD::~PBMetaD() {
   for(unsigned i=0; i<BiasGrids_.size();   ++i) delete BiasGrids_[i];
+  for(unsigned i=0; i<hillbins_.size();    ++i) delete hillbins_[i];
   for(unsigned i=0; i<hillsOfiles_.size(); ++i) {
     hillsOfiles_[i]->close();
     delete hillsOfiles_[i];
@@ -602,6 +607,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
 
   // initializing vector of hills
   hills_.resize(getNumberOfArguments());
+  hillbins_.resize(getNumberOfArguments(),NULL);
 
   // restart from external grid
   bool restartedFromGrid=false;
@@ -836,8 +842,21 @@ void PBMetaD::writeGaussian(unsigned iarg, const Gaussian& hill, OFile *ofile)
 
 void PBMetaD::addGaussian(unsigned iarg, const Gaussian& hill)
 {
-  if(!grid_) {hills_[iarg].push_back(hill);}
-  else {
+  if(!grid_) {
+    // the box is slightly enlarged so as to be safe against rounding errors
+    vector<double> box(1,getGaussianCutoff(hill)*(1.0+1e-6));
+    if(!hillbins_[iarg]) {
+      // bins are as large as the support of the first hill, and are enlarged when wider hills are added
+      hillbins_[iarg]=new HashedBins(vector<double>(1,2.0*box[0]));
+      if(getPntrToArgument(iarg)->isPeriodic()) {
+        double min,max;
+        getPntrToArgument(iarg)->getDomain(min,max);
+        hillbins_[iarg]->setPeriodic(0,min,max);
+      }
+    }
+    hillbins_[iarg]->add(hill.center,box);
+    hills_[iarg].push_back(hill);
+  } else {
     vector<unsigned> nneighb=getGaussianSupport(iarg, hill);
     vector<Grid::index_t> neighbors=BiasGrids_[iarg]->getNeighbors(hill.center,nneighb);
     vector<double> der(1);
@@ -871,9 +890,8 @@ void PBMetaD::addGaussian(unsigned iarg, const Gaussian& hill)
   }
 }
 
-vector<unsigned> PBMetaD::getGaussianSupport(unsigned iarg, const Gaussian& hill)
+double PBMetaD::getGaussianCutoff(const Gaussian& hill)
 {
-  vector<unsigned> nneigh;
   double cutoff;
   if(hill.multivariate) {
     double maxautoval=1./hill.sigma[0];
@@ -881,6 +899,13 @@ vector<unsigned> PBMetaD::getGaussianSupport(unsigned iarg, const Gaussian& hill
   } else {
     cutoff=sqrt(2.0*DP2CUTOFF)*hill.sigma[0];
   }
+  return cutoff;
+}
+
+vector<unsigned> PBMetaD::getGaussianSupport(unsigned iarg, const Gaussian& hill)
+{
+  vector<unsigned> nneigh;
+  double cutoff=getGaussianCutoff(hill);
 
   if(doInt_[iarg]) {
     if(hill.center[0]+cutoff > uppI_[iarg] || hill.center[0]-cutoff < lowI_[iarg]) {
@@ -903,8 +928,15 @@ double PBMetaD::getBiasAndDerivatives(unsigned iarg, const vector<double>& cv, d
   if(!grid_) {
     unsigned stride=comm.Get_size();
     unsigned rank=comm.Get_rank();
-    for(unsigned i=rank; i<hills_[iarg].size(); i+=stride) {
-      bias += evaluateGaussian(iarg,cv,hills_[iarg][i],der);
+    if(hillbins_[iarg]) {
+      // only hills whose support contains cv are evaluated
+      // with INTERVAL, hills are evaluated at the closest boundary
+      vector<double> x(cv);
+      if(doInt_[iarg]) x[0]=std::max(lowI_[iarg],std::min(uppI_[iarg],x[0]));
+      const vector<unsigned> & close(hillbins_[iarg]->get(x));
+      for(unsigned i=rank; i<close.size(); i+=stride) {
+        bias += evaluateGaussian(iarg,cv,hills_[iarg][close[i]],der);
+      }
     }
     comm.Sum(bias);
     if(der) comm.Sum(der,1);
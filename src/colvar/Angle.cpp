@@ -124,6 +124,7 @@ Angle::Angle(const ActionOptions&ao):
 
   addValueWithDerivatives(); setNotPeriodic();
   requestAtoms(atoms);
+  allowRunOnOwner();
   checkRead();
 }
 
@@ -648,6 +648,8 @@ CS2Backbone::CS2Backbone(const ActionOptions&ao):
   unsigned index=0;
   if(camshift) noexp = true;
   if(!camshift) {
+// each chemical shift depends on the atoms that are close to its nucleus only
+    useSparseDerivatives();
     for(unsigned i=0; i<atom.size(); i++) {
       for(unsigned a=0; a<atom[i].size(); a++) {
         unsigned res=index+a;
@@ -50,6 +50,11 @@ but it can be changed using the optional SWITCH option.
 
 To make your calculation faster you can use a neighbor list, which makes it that only a
 relevant subset of the pairwise distance are calculated at every step.
+Instead of updating the list with a fixed NL_STRIDE, you can provide a NL_SKIN. In this case
+the list includes all the pairs closer than NL_CUTOFF plus NL_SKIN and it is updated
+only when one of the atoms has moved by more than half the skin since the last update.
+If NL_CUTOFF is larger than the distance at which the switching function goes to zero
+the result is then identical to the one obtained without the neighbor list.
 
 If GROUPB is empty, it will sum the \f$\frac{N(N-1)}{2}\f$ pairs in GROUPA. This avoids computing
 twice permuted indexes (e.g. pair (i,j) and (j,i)) thus running at twice the speed.
@@ -66,6 +71,12 @@ The following example instructs plumed to calculate the total coordination numbe
 COORDINATION GROUPA=1-10 GROUPB=20-100 R_0=0.3 NLIST NL_CUTOFF=0.5 NL_STRIDE=100
 \endplumedfile
 
+The same calculation can be done with a neighbour list that is updated only when needed.
+Here pairs up to 0.6 nm are stored and the list is updated when one atom moves by more than 0.05 nm.
+\plumedfile
+COORDINATION GROUPA=1-10 GROUPB=20-100 SWITCH={RATIONAL R_0=0.3 D_MAX=0.5} NLIST NL_CUTOFF=0.5 NL_SKIN=0.1
+\endplumedfile
+
 The following is a dummy example which should compute the value 0 because the self interaction
 of atom 1 is skipped. Notice that in plumed 2.0 "self interactions" were not skipped, and the
 same calculation should return 1.
@@ -104,6 +115,7 @@ public:
 // active methods:
   static void registerKeywords( Keywords& keys );
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const;
+  virtual void pairings(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i0,const unsigned*i1)const;
 };
 
 PLUMED_REGISTER_ACTION(Coordination,"COORDINATION")
@@ -153,6 +165,12 @@ double Coordination::pairing(double distance,double&dfunc,unsigned i,unsigned j)
   return switchingFunction.calculateSqr(distance,dfunc);
 }
 
+void Coordination::pairings(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i0,const unsigned*i1)const {
+  (void) i0; // avoid warnings
+  (void) i1; // avoid warnings
+  switchingFunction.calculateSqr(n,distance2,value,dfunc);
+}
+
 }
 
 }
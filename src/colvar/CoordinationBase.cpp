@@ -23,6 +23,8 @@
 #include "tools/NeighborList.h"
 #include "tools/Communicator.h"
 #include "tools/OpenMP.h"
+#include "tools/Profiler.h"
+#include "core/PlumedMain.h"
 
 #include <string>
 
@@ -38,6 +40,7 @@ void CoordinationBase::registerKeywords( Keywords& keys ) {
   keys.addFlag("NLIST",false,"Use a neighbour list to speed up the calculation");
   keys.add("optional","NL_CUTOFF","The cutoff for the neighbour list");
   keys.add("optional","NL_STRIDE","The frequency with which we are updating the atoms in the neighbour list");
+  keys.add("optional","NL_SKIN","Include in the neighbour list all the pairs up to NL_CUTOFF plus this skin, and update it only when some atom has moved by more than half the skin. This cannot be used together with NL_STRIDE");
   keys.add("atoms","GROUPA","First list of atoms");
   keys.add("atoms","GROUPB","Second list of atoms (if empty, N*(N-1)/2 pairs in GROUPA are counted)");
 }
@@ -67,21 +70,26 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
 // neighbor list stuff
   bool doneigh=false;
   double nl_cut=0.0;
+  double nl_skin=0.0;
   int nl_st=0;
   parseFlag("NLIST",doneigh);
   if(doneigh) {
     parse("NL_CUTOFF",nl_cut);
     if(nl_cut<=0.0) error("NL_CUTOFF should be explicitly specified and positive");
+    parse("NL_SKIN",nl_skin);
+    if(nl_skin<0.0) error("NL_SKIN should be positive");
     parse("NL_STRIDE",nl_st);
-    if(nl_st<=0) error("NL_STRIDE should be explicitly specified and positive");
+    if(nl_skin>0.0) {
+      if(nl_st!=0) error("NL_STRIDE cannot be used together with NL_SKIN");
+    } else if(nl_st<=0) error("NL_STRIDE should be explicitly specified and positive");
   }
 
   addValueWithDerivatives(); setNotPeriodic();
   if(gb_lista.size()>0) {
-    if(doneigh)  nl= new NeighborList(ga_lista,gb_lista,dopair,pbc,getPbc(),nl_cut,nl_st);
+    if(doneigh)  nl= new NeighborList(ga_lista,gb_lista,dopair,pbc,getPbc(),nl_cut,nl_st,nl_skin);
     else         nl= new NeighborList(ga_lista,gb_lista,dopair,pbc,getPbc());
   } else {
-    if(doneigh)  nl= new NeighborList(ga_lista,pbc,getPbc(),nl_cut,nl_st);
+    if(doneigh)  nl= new NeighborList(ga_lista,pbc,getPbc(),nl_cut,nl_st,nl_skin);
     else         nl= new NeighborList(ga_lista,pbc,getPbc());
   }
 
@@ -104,11 +112,13 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   if(dopair) log.printf("  with PAIR option\n");
   if(doneigh) {
     log.printf("  using neighbor lists with\n");
-    log.printf("  update every %d steps and cutoff %f\n",nl_st,nl_cut);
+    if(nl_skin>0.0) log.printf("  cutoff %f and skin %f, updated when atoms move by more than half the skin\n",nl_cut,nl_skin);
+    else log.printf("  update every %d steps and cutoff %f\n",nl_st,nl_cut);
   }
 }
 
 CoordinationBase::~CoordinationBase() {
+  if(nl->getSkin()>0.0) log.printf("  neighbor list of action %s was updated %u times\n",getLabel().c_str(),nl->getNumberOfUpdates());
   delete nl;
 }
 
@@ -127,6 +137,10 @@ void CoordinationBase::prepare() {
   }
 }
 
+void CoordinationBase::pairings(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i0,const unsigned*i1)const {
+  for(unsigned k=0; k<n; ++k) value[k]=pairing(distance2[k],dfunc[k],i0[k],i1[k]);
+}
+
 // calculator
 void CoordinationBase::calculate()
 {
@@ -136,8 +150,9 @@ void CoordinationBase::calculate()
   vector<Vector> deriv(getNumberOfAtoms());
 // deriv.resize(getPositions().size());
 
-  if(nl->getStride()>0 && invalidateList) {
+  if((nl->getStride()>0 && invalidateList) || (nl->getSkin()>0.0 && nl->needsUpdate(getPositions()))) {
     nl->update(getPositions());
+    if(plumed.profiler) plumed.profiler->count(getLabel()+" neighbor list updates");
   }
 
   unsigned stride=comm.Get_size();
@@ -157,48 +172,64 @@ void CoordinationBase::calculate()
   if(nt*stride*10>nn) nt=nn/stride/10;
   if(nt==0)nt=1;
 
+// number of pairs handled by this rank
+  const unsigned npairs=(nn>rank ? (nn-rank+stride-1)/stride : 0);
+  const unsigned nblocks=(npairs+pairBlockSize-1)/pairBlockSize;
+
+  std::vector<std::vector<Vector> > omp_deriv(nt>1 ? nt : 0);
+  std::vector<Tensor> omp_virial(nt);
+
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<Vector> omp_deriv(getPositions().size());
-    Tensor omp_virial;
+    const unsigned tid=OpenMP::getThreadNum();
+    if(nt>1) omp_deriv[tid].resize(getPositions().size());
+    std::vector<Vector> & myderiv(nt>1 ? omp_deriv[tid] : deriv);
+    Tensor myvirial;
 
-    #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
+    unsigned block_i0[pairBlockSize], block_i1[pairBlockSize];
+    Vector block_distance[pairBlockSize];
+    double block_d2[pairBlockSize], block_value[pairBlockSize], block_dfunc[pairBlockSize];
 
-      Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
+// pairs are processed in blocks, so that the pairing function is evaluated on many of them at once
+    #pragma omp for reduction(+:ncoord) nowait
+    for(unsigned b=0; b<nblocks; ++b) {
+
+      unsigned n=0;
+      for(unsigned k=b*pairBlockSize; k<npairs && k<(b+1)*pairBlockSize; ++k) {
+        const unsigned i=rank+k*stride;
+        unsigned i0=nl->getClosePair(i).first;
+        unsigned i1=nl->getClosePair(i).second;
+
+        if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+
+        if(pbc) {
+          block_distance[n]=pbcDistance(getPosition(i0),getPosition(i1));
+        } else {
+          block_distance[n]=delta(getPosition(i0),getPosition(i1));
+        }
+        block_d2[n]=block_distance[n].modulo2();
+        block_i0[n]=i0;
+        block_i1[n]=i1;
+        n++;
+      }
 
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+      pairings(n,block_d2,block_value,block_dfunc,block_i0,block_i1);
 
-      if(pbc) {
-        distance=pbcDistance(getPosition(i0),getPosition(i1));
-      } else {
-        distance=delta(getPosition(i0),getPosition(i1));
-      }
+      for(unsigned k=0; k<n; ++k) {
+        ncoord += block_value[k];
 
-      double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
-
-      Vector dd(dfunc*distance);
-      Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
-        omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
+        Vector dd(block_dfunc[k]*block_distance[k]);
+        Tensor vv(dd,block_distance[k]);
+        myderiv[block_i0[k]]-=dd;
+        myderiv[block_i1[k]]+=dd;
+        myvirial-=vv;
       }
 
     }
-    #pragma omp critical
-    if(nt>1) {
-      for(int i=0; i<getPositions().size(); i++) deriv[i]+=omp_deriv[i];
-      virial+=omp_virial;
-    }
+    omp_virial[tid]=myvirial;
+    if(nt>1) OpenMP::sumOverThreads(omp_deriv,deriv);
   }
+  for(unsigned t=0; t<nt; ++t) virial+=omp_virial[t];
 
   if(!serial) {
     comm.Sum(ncoord);
@@ -30,6 +30,8 @@ class NeighborList;
 namespace colvar {
 
 class CoordinationBase : public Colvar {
+/// Number of pairs passed at once to pairings()
+  static const unsigned pairBlockSize=64;
   bool pbc;
   bool serial;
   NeighborList *nl;
@@ -43,6 +45,10 @@ public:
   virtual void calculate();
   virtual void prepare();
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const=0;
+/// Compute the pairing function on n pairs at once.
+/// The default implementation calls pairing() on each of them, it can be overridden
+/// when a faster implementation is available
+  virtual void pairings(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i0,const unsigned*i1)const;
   static void registerKeywords( Keywords& keys );
 };
 
@@ -173,6 +173,7 @@ Distance::Distance(const ActionOptions&ao):
 
 
   requestAtoms(atoms);
+  allowRunOnOwner();
 }
 
 
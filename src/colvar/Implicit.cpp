@@ -190,9 +190,12 @@ void Implicit::calculate() {
   const unsigned nn=nl.size();
   if(nt*10>nn) nt=nn/10;
   if(nt==0)nt=1;
+  vector<Vector> derivatives(size);
+  vector<vector<Vector> > deriv_omp(nt>1 ? nt : 0);
   #pragma omp parallel num_threads(nt)
   {
-    vector<Vector> deriv_omp(size);
+    if(nt>1) deriv_omp[OpenMP::getThreadNum()].resize(size);
+    vector<Vector> & myderiv(nt>1 ? deriv_omp[OpenMP::getThreadNum()] : derivatives);
     #pragma omp for reduction(+:bias)
     for (unsigned i=0; i<size; ++i) {
       const Vector posi = getPosition(i);
@@ -257,16 +260,17 @@ void Implicit::calculate() {
 
         const Vector dd = deriv*dist;
         deriv_i      += dd;
-        deriv_omp[j] -= dd;
+        myderiv[j] -= dd;
       }
-      deriv_omp[i] += deriv_i;
+      myderiv[i] += deriv_i;
       bias += - 0.5 * fedensity;
     }
-    #pragma omp critical
-    for(unsigned i=0; i<size; i++) {
-      setAtomsDerivatives(i, -deriv_omp[i]);
-      deriv_box += Tensor(getPosition(i), -deriv_omp[i]);
-    }
+    if(nt>1) OpenMP::sumOverThreads(deriv_omp,derivatives);
+  }
+
+  for(unsigned i=0; i<size; i++) {
+    setAtomsDerivatives(i, -derivatives[i]);
+    deriv_box += Tensor(getPosition(i), -derivatives[i]);
   }
 
   setBoxDerivatives(-deriv_box);
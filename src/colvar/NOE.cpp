@@ -157,6 +157,8 @@ NOE::NOE(const ActionOptions&ao):
   if(pbc)      log.printf("  using periodic boundary conditions\n");
   else         log.printf("  without periodic boundary conditions\n");
 
+// each component depends on the atoms of one NOE only
+  useSparseDerivatives();
   for(unsigned i=0; i<nga.size(); i++) {
     string num; Tools::convert(i,num);
     addComponentWithDerivatives("noe_"+num);
@@ -121,6 +121,7 @@ Position::Position(const ActionOptions&ao):
   }
 
   requestAtoms(atoms);
+  allowRunOnOwner();
 }
 
 
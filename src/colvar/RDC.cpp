@@ -231,6 +231,8 @@ RDC::RDC(const ActionOptions&ao):
 
   checkRead();
 
+// each component depends on the two atoms of one coupling only
+  if(!svd) useSparseDerivatives();
   for(unsigned i=0; i<ndata; i++) {
     std::string num; Tools::convert(i,num);
     if(!svd) {
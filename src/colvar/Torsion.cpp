@@ -138,6 +138,7 @@ Torsion::Torsion(const ActionOptions&ao):
   if(!do_cosine) setPeriodic("-pi","pi");
   else setNotPeriodic();
   requestAtoms(atoms);
+  allowRunOnOwner();
 }
 
 // calculator
@@ -49,6 +49,9 @@ ActionAtomistic::ActionAtomistic(const ActionOptions&ao):
   lockRequestAtoms(false),
   donotretrieve(false),
   donotforce(false),
+  canRunOnOwner(false),
+  runOnOwner(false),
+  owner(true),
   atoms(plumed.getAtoms())
 {
   atoms.add(this);
@@ -78,7 +81,7 @@ void ActionAtomistic::requestAtoms(const vector<AtomNumber> & a) {
     else unique.insert(indexes[i]);
   }
   updateUniqueLocal();
-  atoms.unique.clear();
+  atoms.clearUnique();
 }
 
 Vector ActionAtomistic::pbcDistance(const Vector &v1,const Vector &v2)const {
@@ -61,6 +61,13 @@ class ActionAtomistic :
   bool                  donotretrieve;
   bool                  donotforce;
 
+/// calculate() does not communicate, so that it can be run by a single process
+  bool                  canRunOnOwner;
+/// in this step calculate() is run only by the process owning most of the atoms
+  bool                  runOnOwner;
+/// this process owns most of the atoms
+  bool                  owner;
+
 protected:
   Atoms&                atoms;
 
@@ -147,6 +154,10 @@ public:
   void doNotForce() {donotforce=true;}
 /// Make atoms whole, assuming they are in the proper order
   void makeWhole();
+/// Declare that calculate() does not use communications among processes.
+/// With domain decomposition and PLUMED_OWNER_COMPUTES=yes, calculate() is then run only by the
+/// process owning most of the atoms, and positions are sent only to that process
+  void allowRunOnOwner() {canRunOnOwner=true;}
 /// Allow calls to modifyGlobalForce()
   void allowToAccessGlobalForces() {atoms.zeroallforces=true;}
 /// updates local unique atoms
@@ -175,6 +186,14 @@ public:
   void unlockRequests();
   const std::set<AtomNumber> & getUnique()const;
   const std::set<AtomNumber> & getUniqueLocal()const;
+/// Check if calculate() can be run by a single process
+  bool getCanRunOnOwner()const {return canRunOnOwner;}
+/// Set if in this step calculate() is run only by its owner, and if this process is the owner
+  void setRunOnOwner(bool run,bool o) {runOnOwner=run; owner=o;}
+/// Check if in this step calculate() is run only by its owner
+  bool isRunOnOwner()const {return runOnOwner;}
+/// Check if this process should run calculate()
+  bool isOwner()const {return owner;}
 /// Read in an input file containing atom positions and calculate the action for the atomic
 /// configuration therin
   void readAtomsFromPDB( const PDB& pdb );
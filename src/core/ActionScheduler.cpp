@@ -0,0 +1,232 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "ActionScheduler.h"
+#include "ActionAtomistic.h"
+#include "ActionWithValue.h"
+#include "ActionWithVirtualAtom.h"
+#include "tools/Exception.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+
+namespace PLMD {
+
+PlannedAction::PlannedAction( Action* a, const unsigned& i ):
+  action(a),
+  av(dynamic_cast<ActionWithValue*>(a)),
+  aa(dynamic_cast<ActionAtomistic*>(a)),
+  avv(dynamic_cast<ActionWithVirtualAtom*>(a)),
+  bias(NULL),
+  work(NULL),
+  index(i)
+{
+  if(!av) return;
+  for(int i=0; i<av->getNumberOfComponents(); ++i) {
+    Value* v=av->copyOutput(i);
+    if( v->getName()==a->getLabel()+".bias" ) bias=v;
+    else if( v->getName()==a->getLabel()+".work" ) work=v;
+  }
+}
+
+void ActionScheduler::calculateAction( const PlannedAction& pa ) {
+  Action* p=pa.action; ActionWithValue*av=pa.av; ActionAtomistic*aa=pa.aa;
+  {
+    if(av) av->clearInputForces();
+    if(av) av->clearDerivatives();
+  }
+  {
+    if(aa) aa->clearOutputForces();
+    if(aa) if(aa->isActive() && aa->isOwner()) aa->retrieveAtoms();
+  }
+// in owner-computes mode only one process calculates, values and derivatives are then shared
+  if(!aa || aa->isOwner()) {
+    if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
+    else p->calculate();
+  }
+// in owner-computes mode gradients are set once the values are summed over the processes (see PlumedMain::sumOwnedActions())
+  if(av && !(aa && aa->isRunOnOwner())) av->setGradientsIfNeeded();
+  if(pa.avv)pa.avv->setGradientsIfNeeded();
+}
+
+void ActionScheduler::applyAction( const PlannedAction& pa ) {
+  pa.action->apply();
+// still ActionAtomistic has a special treatment, since they may need to add forces on atoms
+  if(pa.aa) pa.aa->applyForces();
+}
+
+void ActionScheduler::clear() {
+  taskAction.resize(0); taskType.resize(0);
+  successors.resize(0); npredecessors.resize(0);
+}
+
+unsigned ActionScheduler::addTask( const PlannedAction& a, const TaskType& t ) {
+  taskAction.push_back( &a ); taskType.push_back( t );
+  successors.push_back( std::vector<unsigned>() ); npredecessors.push_back( 0 );
+  return taskAction.size()-1;
+}
+
+void ActionScheduler::addEdge( const unsigned& i, const unsigned& j ) {
+  plumed_dbg_assert( i<j );
+  successors[i].push_back( j ); npredecessors[j]++;
+}
+
+void ActionScheduler::setupActions( const std::vector<PlannedAction>& actions ) {
+  actionIndex.clear();
+  for(unsigned i=0; i<actions.size(); ++i) actionIndex[actions[i].action]=i;
+  barrier.assign( actions.size(), false );
+  for(unsigned i=0; i<actions.size(); ++i) {
+    // Actions without values may modify the positions and forces of any atom
+    if( !actions[i].av ) { barrier[i]=true; continue; }
+    // In the serial loop an action that depends on one that comes after it uses old data
+    const Action::Dependencies & deps( actions[i].action->getDependencies() );
+    for(unsigned j=0; j<deps.size(); ++j) {
+      std::unordered_map<const Action*,unsigned>::const_iterator it=actionIndex.find( deps[j] );
+      if( it!=actionIndex.end() && it->second>=i ) barrier[i]=true;
+    }
+  }
+}
+
+void ActionScheduler::calculate( const std::vector<PlannedAction>& actions, const unsigned& nt ) {
+  clear(); setupActions( actions );
+  // The last action that used the data of each action
+  std::vector<int> lastUser( actions.size(), -1 );
+  int lastBarrier=-1; std::vector<unsigned> sinceBarrier;
+  for(unsigned i=0; i<actions.size(); ++i) {
+    unsigned t=addTask( actions[i], CALCULATE );
+    if( lastBarrier>=0 ) addEdge( lastBarrier, t );
+    if( barrier[i] ) {
+      for(unsigned j=0; j<sinceBarrier.size(); ++j) addEdge( sinceBarrier[j], t );
+      sinceBarrier.resize(0); lastBarrier=t;
+    } else {
+      // An action is calculated once all the actions it depends on have been calculated.  Actions that
+      // use the same action are calculated in the order of the serial loop, as they may share its work space
+      const Action::Dependencies & deps( actions[i].action->getDependencies() );
+      for(unsigned j=0; j<deps.size(); ++j) {
+        std::unordered_map<const Action*,unsigned>::const_iterator it=actionIndex.find( deps[j] );
+        if( it==actionIndex.end() ) continue;
+        addEdge( it->second, t );
+        if( lastUser[it->second]>=0 && lastUser[it->second]!=static_cast<int>(i) ) addEdge( lastUser[it->second], t );
+        lastUser[it->second]=i;
+      }
+      sinceBarrier.push_back( t );
+    }
+  }
+  run( nt );
+}
+
+void ActionScheduler::apply( const std::vector<PlannedAction>& actions, const unsigned& nt ) {
+  clear(); setupActions( actions );
+  const unsigned n=actions.size();
+  // The last task of each action and the last action that added forces on the values of each action
+  std::vector<unsigned> lastTask( n ); std::vector<int> lastUser( n, -1 );
+  int lastBarrier=-1, lastForces=-1; std::vector<unsigned> sinceBarrier;
+  // Actions are applied in reverse order
+  for(unsigned k=0; k<n; ++k) {
+    const unsigned i=n-1-k; const PlannedAction& p=actions[i];
+    // Virtual atoms read the forces on the virtual atom so the forces on the atoms are applied in the same task
+    const bool all=( barrier[i] || p.avv );
+    unsigned t=addTask( p, all ? APPLY_ALL : APPLY ); lastTask[i]=t;
+    if( lastBarrier>=0 ) addEdge( lastBarrier, t );
+    if( barrier[i] ) {
+      for(unsigned j=0; j<sinceBarrier.size(); ++j) addEdge( sinceBarrier[j], t );
+      sinceBarrier.resize(0);
+    }
+    // Forces are applied once all the actions that use this one have added their forces
+    if( lastUser[i]>=0 ) addEdge( lastTask[lastUser[i]], t );
+    // Actions that add forces on the same action do so in the order of the serial loop
+    const Action::Dependencies & deps( p.action->getDependencies() );
+    for(unsigned j=0; j<deps.size(); ++j) {
+      std::unordered_map<const Action*,unsigned>::const_iterator it=actionIndex.find( deps[j] );
+      if( it==actionIndex.end() ) continue;
+      if( lastUser[it->second]>=0 && lastUser[it->second]!=static_cast<int>(i) ) addEdge( lastTask[lastUser[it->second]], t );
+      lastUser[it->second]=i;
+    }
+    // Forces are added on the atoms in the order of the serial loop
+    if( p.aa ) {
+      if( !all ) { lastTask[i]=addTask( p, APPLY_FORCES ); addEdge( t, lastTask[i] ); }
+      if( lastForces>=0 ) addEdge( lastForces, lastTask[i] );
+      lastForces=lastTask[i];
+    }
+    if( barrier[i] ) lastBarrier=t;
+    else {
+      sinceBarrier.push_back( t );
+      if( lastTask[i]!=t ) sinceBarrier.push_back( lastTask[i] );
+    }
+  }
+  run( nt );
+}
+
+void ActionScheduler::runTask( const unsigned& itask ) const {
+  const PlannedAction& p=*taskAction[itask];
+  switch( taskType[itask] ) {
+  case CALCULATE: calculateAction( p ); break;
+  case APPLY: p.action->apply(); break;
+  case APPLY_FORCES: p.aa->applyForces(); break;
+  case APPLY_ALL: applyAction( p ); break;
+  }
+}
+
+void ActionScheduler::run( const unsigned& nt ) {
+  const unsigned ntasks=taskAction.size();
+  std::vector<unsigned> waiting( npredecessors );
+  // When more tasks are ready the one that comes first in the serial loop is run first
+  std::priority_queue<unsigned,std::vector<unsigned>,std::greater<unsigned> > ready;
+  for(unsigned i=0; i<ntasks; ++i) if( waiting[i]==0 ) ready.push( i );
+  unsigned ndone=0; bool failed=false; std::exception_ptr exc;
+  // Threads with nothing to do sleep until a task is done
+  std::mutex mtx; std::condition_variable changed;
+
+  #pragma omp parallel num_threads(nt)
+  {
+    while( true ) {
+      unsigned itask=0;
+      {
+        std::unique_lock<std::mutex> lock( mtx );
+        changed.wait( lock, [&] { return ndone==ntasks || failed || !ready.empty(); } );
+        if( ndone==ntasks || failed ) break;
+        itask=ready.top(); ready.pop();
+      }
+      // Exceptions cannot leave the parallel region so they are thrown again at the end
+      try {
+        runTask( itask );
+      } catch(...) {
+        std::lock_guard<std::mutex> lock( mtx );
+        if( !failed ) exc=std::current_exception();
+        failed=true;
+      }
+      {
+        std::lock_guard<std::mutex> lock( mtx );
+        for(unsigned j=0; j<successors[itask].size(); ++j) {
+          unsigned s=successors[itask][j];
+          if( --waiting[s]==0 ) ready.push( s );
+        }
+        ndone++;
+      }
+      changed.notify_all();
+    }
+  }
+  if( failed ) std::rethrow_exception( exc );
+}
+
+}
@@ -0,0 +1,107 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_core_ActionScheduler_h
+#define __PLUMED_core_ActionScheduler_h
+
+#include <vector>
+#include <unordered_map>
+
+namespace PLMD {
+
+class Action;
+class ActionWithValue;
+class ActionAtomistic;
+class ActionWithVirtualAtom;
+class Value;
+
+/**
+An action with the pointers that are used to run it in the forward and backward loops.
+The pointers are found with dynamic_cast once, when the action is created, rather than at every step.
+*/
+class PlannedAction {
+public:
+  Action* action;
+  ActionWithValue* av;
+  ActionAtomistic* aa;
+  ActionWithVirtualAtom* avv;
+/// The components called bias and work, which are summed to get the total bias and work (NULL if absent)
+  Value* bias;
+  Value* work;
+/// The position of the action in the input
+  unsigned index;
+  PlannedAction( Action* a, const unsigned& i );
+};
+
+/**
+Runs the forward and backward loops over the active actions concurrently.
+
+A directed acyclic graph is built from the dependencies of the actions (see Action::addDependency)
+and the actions are run by the OpenMP threads as soon as all the actions they depend on are done.
+Actions that depend on the same action are run in the order of the serial loop, since they may
+use the work space of that action.  In the backward loop the forces are propagated from each action to the actions it depends on, so
+the edges of the graph are reversed.  The forces on the atoms are also added in the order of the serial
+loop, so that the results do not depend on the number of threads.  Actions that have no
+values (e.g. \ref WHOLEMOLECULES) can modify the positions or forces of all the atoms, so they are run
+after all the actions before them and before all the actions after them.  Actions may communicate while they
+are calculated, so the scheduler is only used when MPI is not initialized (see PlumedMain::useScheduler()).
+*/
+class ActionScheduler {
+private:
+/// The types of task
+  enum TaskType { CALCULATE, APPLY, APPLY_FORCES, APPLY_ALL };
+/// The action of each task and what is done
+  std::vector<const PlannedAction*> taskAction;
+  std::vector<TaskType> taskType;
+/// The tasks that can only start after each task is done
+  std::vector<std::vector<unsigned> > successors;
+/// The number of tasks that must be done before each task can start
+  std::vector<unsigned> npredecessors;
+/// The position of each action in the loop
+  std::unordered_map<const Action*,unsigned> actionIndex;
+/// Is each action run only after all the actions before it in the loop
+  std::vector<bool> barrier;
+/// Delete all the tasks
+  void clear();
+/// Add a task and return its index
+  unsigned addTask( const PlannedAction& a, const TaskType& t );
+/// Task i must be done before task j starts
+  void addEdge( const unsigned& i, const unsigned& j );
+/// Set the index of the actions and find the ones that are barriers
+  void setupActions( const std::vector<PlannedAction>& actions );
+/// Run all the tasks
+  void run( const unsigned& nt );
+/// Run one task
+  void runTask( const unsigned& itask ) const ;
+public:
+/// Calculate one action, i.e. do what is done in the forward loop
+  static void calculateAction( const PlannedAction& p );
+/// Apply the forces of one action, i.e. do what is done in the backward loop
+  static void applyAction( const PlannedAction& p );
+/// Calculate the active actions (which should be passed in the order they appear in the input)
+  void calculate( const std::vector<PlannedAction>& actions, const unsigned& nt );
+/// Apply the forces of the active actions (which should be passed in the order they appear in the input)
+  void apply( const std::vector<PlannedAction>& actions, const unsigned& nt );
+};
+
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include "ActionWithValue.h"
 #include "tools/Exception.h"
 #include "tools/OpenMP.h"
+#include "tools/Communicator.h"
 
 using namespace std;
 namespace PLMD {
@@ -55,7 +56,8 @@ void ActionWithValue::useCustomisableComponents(Keywords& keys) {
 ActionWithValue::ActionWithValue(const ActionOptions&ao):
   Action(ao),
   noderiv(true),
-  numericalDerivatives(false)
+  numericalDerivatives(false),
+  sparseDerivatives(false)
 {
   if( keywords.exists("NUMERICAL_DERIVATIVES") ) parseFlag("NUMERICAL_DERIVATIVES",numericalDerivatives);
   if(numericalDerivatives) log.printf("  using numerical derivatives\n");
@@ -78,6 +80,39 @@ void ActionWithValue::clearDerivatives() {
   }
 }
 
+void ActionWithValue::addToSumBuffer(std::vector<double>& buffer,bool owner)const {
+  unsigned k=buffer.size(), n=0;
+  for(unsigned i=0; i<values.size(); i++) n+=1+values[i]->nderivatives;
+  buffer.resize(k+n,0.0);
+  if(!owner) return;
+  for(unsigned i=0; i<values.size(); i++) {
+    buffer[k++]=values[i]->value;
+    for(unsigned j=0; j<values[i]->getNumberActive(); j++) buffer[k+values[i]->getActiveIndex(j)]=values[i]->derivatives[j];
+    k+=values[i]->nderivatives;
+  }
+}
+
+void ActionWithValue::retrieveFromSumBuffer(const std::vector<double>& buffer,unsigned& k) {
+  for(unsigned i=0; i<values.size(); i++) {
+    values[i]->value=buffer[k++];
+    if(values[i]->sparse) {
+      // the derivatives that are not zero on any process are stored
+      values[i]->derivativeIndices.resize(0); values[i]->derivatives.resize(0);
+      for(unsigned j=0; j<values[i]->nderivatives; j++) {
+        if(buffer[k+j]!=0) { values[i]->derivativeIndices.push_back(j); values[i]->derivatives.push_back(buffer[k+j]); }
+      }
+    } else {
+      for(unsigned j=0; j<values[i]->nderivatives; j++) values[i]->derivatives[j]=buffer[k+j];
+    }
+    k+=values[i]->nderivatives;
+  }
+}
+
+void ActionWithValue::useSparseDerivatives() {
+  sparseDerivatives=true;
+  for(unsigned i=0; i<values.size(); i++) values[i]->setSparseDerivatives(true);
+}
+
 // -- These are the routine for copying the value pointers to other classes -- //
 
 bool ActionWithValue::exists( const std::string& name ) const {
@@ -110,6 +145,7 @@ void ActionWithValue::addValue() {
 void ActionWithValue::addValueWithDerivatives() {
   plumed_massert(values.empty(),"You have already added the default value for this action");
   values.push_back(new Value(this,getLabel(), true ) );
+  values.back()->setSparseDerivatives(sparseDerivatives);
 }
 
 void ActionWithValue::setNotPeriodic() {
@@ -163,6 +199,7 @@ void ActionWithValue::addComponentWithDerivatives( const std::string& name ) {
     plumed_massert(values[i]->name!=thename,"there is already a value with this name");
   }
   values.push_back(new Value(this,thename, true ) );
+  values.back()->setSparseDerivatives(sparseDerivatives);
   std::string msg="  added component to this action:  "+thename+" \n";
   log.printf(msg.c_str());
 }
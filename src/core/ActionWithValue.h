@@ -72,6 +72,8 @@ private:
   bool noderiv;
 /// Are we using numerical derivatives to differentiate
   bool numericalDerivatives;
+/// Are only the non-zero derivatives of the values stored
+  bool sparseDerivatives;
 /// Return the index for the component named name
   int getComponent( const std::string& name ) const;
 public:
@@ -104,6 +106,9 @@ public:
 /// Set the value to be periodic with a particular domain
   void componentIsPeriodic( const std::string& name, const std::string& min, const std::string& max );
 protected:
+/// Store only the non-zero derivatives of the values, which saves memory and time when each of them
+/// depends on a few of the atoms or arguments.  It applies to the values that are added later too.
+  void useSparseDerivatives();
 /// Return a pointer to the component by index
   Value* getPntrToComponent(int i);
 /// Return a pointer to the value by name
@@ -156,6 +161,11 @@ public:
   virtual void clearDerivatives();
 /// Calculate the gradients and store them for all the values (need for projections)
   void setGradientsIfNeeded();
+/// Append values and derivatives to a buffer that is then summed over the processes.
+/// Used when calculate() was run by a single process, the others passing owner=false so that zeros are appended
+  void addToSumBuffer(std::vector<double>& buffer,bool owner)const;
+/// Set values and derivatives from the summed buffer, reading from position k which is then moved after them
+  void retrieveFromSumBuffer(const std::vector<double>& buffer,unsigned& k);
 /// Set the value
   void setValue(Value*,double);
 /// Check if numerical derivatives should be used
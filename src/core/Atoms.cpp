@@ -41,6 +41,8 @@ class PlumedMain;
 
 Atoms::Atoms(PlumedMain&plumed):
   natoms(0),
+  uniqueChanged(true),
+  uniqueIsAll(false),
   pbc(*new Pbc),
   energy(0.0),
   dataCanBeSet(false),
@@ -62,7 +64,8 @@ Atoms::Atoms(PlumedMain&plumed):
   kbT(0.0),
   asyncSent(false),
   atomsNeeded(false),
-  ddStep(0)
+  ddStep(0),
+  ownerStep(false)
 {
   mdatoms=MDAtomsBase::create(sizeof(double));
 }
@@ -145,31 +148,117 @@ void Atoms::share() {
     return;
   }
 
-  if(!(int(gatindex.size())==natoms && shuffledAtoms==0)) {
-    for(unsigned i=0; i<actions.size(); i++) {
-      if(actions[i]->isActive()) {
-        if(!actions[i]->getUnique().empty()) {
-          atomsNeeded=true;
-          // unique are the local atoms
-          unique.insert(actions[i]->getUniqueLocal().begin(),actions[i]->getUniqueLocal().end());
-        }
-      }
+  if(uniqueIsAll) {
+    clearUnique();
+    uniqueIsAll=false;
+  }
+  if(uniqueMerged.size()!=actions.size()) uniqueMerged.assign(actions.size(),false);
+// atoms of actions that are not active anymore (e.g. with a STRIDE) should not be shared
+  for(unsigned i=0; i<actions.size(); i++) if(uniqueMerged[i] && !actions[i]->isActive()) {
+      clearUnique();
+      break;
     }
-  } else {
-    for(unsigned i=0; i<actions.size(); i++) {
-      if(actions[i]->isActive()) {
-        if(!actions[i]->getUnique().empty()) {
-          atomsNeeded=true;
+
+  for(unsigned i=0; i<actions.size(); i++) {
+    if(actions[i]->isActive()) {
+      if(!actions[i]->getUnique().empty()) {
+        atomsNeeded=true;
+        // unique are the local atoms
+        // they are merged only once, until requests change
+        if(!uniqueMerged[i]) {
+          unique.insert(actions[i]->getUniqueLocal().begin(),actions[i]->getUniqueLocal().end());
+          uniqueMerged[i]=true;
+          uniqueChanged=true;
         }
       }
     }
+  }
 
+  const bool wasOwnerStep=ownerStep;
+  ownerStep=dd && shuffledAtoms>0 && dd.ownerComputes;
+  if(ownerStep || wasOwnerStep) {
+    for(unsigned i=0; i<actions.size(); i++) actions[i]->setRunOnOwner(false,true);
   }
+  if(ownerStep) shareOwners();
 
   share(unique);
 }
 
+void Atoms::shareOwners() {
+  const int nranks=dd.Get_size();
+  const int rank=dd.Get_rank();
+  uniqueGathered.clear();
+  vector<ActionAtomistic*> owned;
+  for(unsigned i=0; i<actions.size(); i++) {
+    if(!actions[i]->isActive() || actions[i]->getUnique().empty()) continue;
+    if(actions[i]->getCanRunOnOwner()) owned.push_back(actions[i]);
+    else uniqueGathered.insert(actions[i]->getUniqueLocal().begin(),actions[i]->getUniqueLocal().end());
+  }
+// owner is the process with most atoms, the one with lowest rank in case of ties
+  vector<int> keys(owned.size());
+  for(unsigned i=0; i<owned.size(); i++) keys[i]=owned[i]->getUniqueLocal().size()*nranks+(nranks-1-rank);
+  if(!keys.empty()) dd.Max(keys);
+  dd.indexToOwner.resize(nranks);
+  for(int i=0; i<nranks; i++) dd.indexToOwner[i].clear();
+  for(unsigned i=0; i<owned.size(); i++) {
+    const int owner=nranks-1-keys[i]%nranks;
+    owned[i]->setRunOnOwner(true,owner==rank);
+    if(owner==rank) continue;
+    for(const auto & p : owned[i]->getUniqueLocal()) dd.indexToOwner[owner].push_back(p.index());
+  }
+  for(int i=0; i<nranks; i++) {
+    sort(dd.indexToOwner[i].begin(),dd.indexToOwner[i].end());
+    dd.indexToOwner[i].erase(std::unique(dd.indexToOwner[i].begin(),dd.indexToOwner[i].end()),dd.indexToOwner[i].end());
+  }
+}
+
+void Atoms::exchangeOwned(int ndata) {
+  const int n=dd.Get_size();
+  vector<int> scounts(n),sdispl(n),rcounts(n),rdispl(n);
+  vector<int> scountsd(n),sdispld(n),rcountsd(n),rdispld(n);
+  for(int i=0; i<n; i++) scounts[i]=dd.indexToOwner[i].size();
+  dd.Alltoall(scounts,rcounts);
+  sdispl[0]=rdispl[0]=0;
+  for(int i=1; i<n; i++) sdispl[i]=sdispl[i-1]+scounts[i-1];
+  for(int i=1; i<n; i++) rdispl[i]=rdispl[i-1]+rcounts[i-1];
+  for(int i=0; i<n; i++) {
+    scountsd[i]=ndata*scounts[i]; sdispld[i]=ndata*sdispl[i];
+    rcountsd[i]=ndata*rcounts[i]; rdispld[i]=ndata*rdispl[i];
+  }
+  const int stot=sdispl[n-1]+scounts[n-1];
+  const int rtot=rdispl[n-1]+rcounts[n-1];
+  vector<int> sindex(stot>0?stot:1),rindex(rtot>0?rtot:1);
+  vector<double> sdata(stot>0?ndata*stot:1),rdata(rtot>0?ndata*rtot:1);
+  int k=0;
+  for(int i=0; i<n; i++) for(const auto & a : dd.indexToOwner[i]) {
+      sindex[k]=a;
+      sdata[ndata*k+0]=positions[a][0];
+      sdata[ndata*k+1]=positions[a][1];
+      sdata[ndata*k+2]=positions[a][2];
+      if(ndata>3) {
+        sdata[ndata*k+3]=masses[a];
+        sdata[ndata*k+4]=charges[a];
+      }
+      k++;
+    }
+  dd.Alltoallv(&sindex[0],&scounts[0],&sdispl[0],&rindex[0],&rcounts[0],&rdispl[0]);
+  dd.Alltoallv(&sdata[0],&scountsd[0],&sdispld[0],&rdata[0],&rcountsd[0],&rdispld[0]);
+  for(int i=0; i<rtot; i++) {
+    positions[rindex[i]][0]=rdata[ndata*i+0];
+    positions[rindex[i]][1]=rdata[ndata*i+1];
+    positions[rindex[i]][2]=rdata[ndata*i+2];
+    if(ndata>3) {
+      masses[rindex[i]] =rdata[ndata*i+3];
+      charges[rindex[i]]=rdata[ndata*i+4];
+    }
+  }
+}
+
 void Atoms::shareAll() {
+  if(ownerStep) {
+    for(unsigned i=0; i<actions.size(); i++) actions[i]->setRunOnOwner(false,true);
+    ownerStep=false;
+  }
   unique.clear();
   // keep in unique only those atoms that are local
   if(dd && shuffledAtoms>0) {
@@ -177,15 +266,29 @@ void Atoms::shareAll() {
   } else {
     for(int i=0; i<natoms; i++) unique.insert(AtomNumber::index(i));
   }
+  uniqueChanged=true;
+  uniqueIsAll=true;
   atomsNeeded=true;
   share(unique);
 }
 
+void Atoms::clearUnique() {
+  for(const auto & p : unique) if(p.index()<forces.size()) forces[p.index()].zero();
+  unique.clear();
+  uniqueMerged.assign(actions.size(),false);
+  uniqueChanged=true;
+}
+
+bool Atoms::shareAllAtoms()const {
+  return int(gatindex.size())==natoms && shuffledAtoms==0 && (zeroallforces || 2*unique.size()>=gatindex.size());
+}
+
 void Atoms::share(const std::set<AtomNumber>& unique) {
   plumed_assert( positionsHaveBeenSet==3 && massesHaveBeenSet );
 
   virial.zero();
-  if(zeroallforces || int(gatindex.size())==natoms) {
+// forces on atoms that are not in unique are always zero, see clearUnique()
+  if(zeroallforces) {
     for(int i=0; i<natoms; i++) forces[i].zero();
   } else {
     for(const auto & p : unique) forces[p.index()].zero();
@@ -197,10 +300,7 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
   if(!atomsNeeded) return;
   atomsNeeded=false;
 
-  if(int(gatindex.size())==natoms && shuffledAtoms==0) {
-// faster version, which retrieves all atoms
-    mdatoms->getPositions(0,natoms,positions);
-  } else {
+  if(uniqueChanged) {
     uniq_index.clear();
     uniq_index.reserve(unique.size());
     if(dd && shuffledAtoms>0) {
@@ -208,6 +308,13 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
     } else {
       for(const auto & p : unique) uniq_index.push_back(p.index());
     }
+    uniqueChanged=false;
+  }
+
+  if(shareAllAtoms()) {
+// faster version, which retrieves all atoms
+    mdatoms->getPositions(0,natoms,positions);
+  } else {
     mdatoms->getPositions(unique,uniq_index,positions);
   }
 
@@ -228,7 +335,7 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
       for(unsigned i=0; i<dd.mpi_request_index.size(); i++)     dd.mpi_request_index[i].wait();
     }
     int count=0;
-    for(const auto & p : unique) {
+    for(const auto & p : (ownerStep?uniqueGathered:unique)) {
       dd.indexToBeSent[count]=p.index();
       dd.positionsToBeSent[ndata*count+0]=positions[p.index()][0];
       dd.positionsToBeSent[ndata*count+1]=positions[p.index()][1];
@@ -239,7 +346,20 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
       }
       count++;
     }
-    if(dd.async) {
+    if(dd.shared) {
+      const int* index;
+      const double* data;
+      int tot=dd.gatherShared(count,ndata,natoms,index,data);
+      for(int i=0; i<tot; i++) {
+        positions[index[i]][0]=data[ndata*i+0];
+        positions[index[i]][1]=data[ndata*i+1];
+        positions[index[i]][2]=data[ndata*i+2];
+        if(!massAndChargeOK) {
+          masses[index[i]]      =data[ndata*i+3];
+          charges[index[i]]     =data[ndata*i+4];
+        }
+      }
+    } else if(dd.async) {
       asyncSent=true;
       dd.mpi_request_positions.resize(dd.Get_size());
       dd.mpi_request_index.resize(dd.Get_size());
@@ -271,6 +391,7 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
         }
       }
     }
+    if(ownerStep) exchangeOwned(ndata);
   }
 }
 
@@ -323,7 +444,7 @@ void Atoms::updateForces() {
     mdatoms->rescaleForces(gatindex,alpha);
     mdatoms->updateForces(gatindex,forces);
   } else {
-    if(int(gatindex.size())==natoms && shuffledAtoms==0) mdatoms->updateForces(gatindex,forces);
+    if(shareAllAtoms()) mdatoms->updateForces(gatindex,forces);
     else mdatoms->updateForces(unique,uniq_index,forces);
   }
   if( !plumed.novirial && dd.Get_rank()==0 ) {
@@ -345,12 +466,14 @@ void Atoms::setNatoms(int n) {
 
 void Atoms::add(ActionAtomistic*a) {
   actions.push_back(a);
+  clearUnique();
 }
 
 void Atoms::remove(ActionAtomistic*a) {
   auto f=find(actions.begin(),actions.end(),a);
   plumed_massert(f!=actions.end(),"cannot remove an action registered to atoms");
   actions.erase(f);
+  clearUnique();
 }
 
 
@@ -364,6 +487,79 @@ void Atoms::DomainDecomposition::enable(Communicator& c) {
     else if(s=="no") async=false;
     else plumed_merror("PLUMED_ASYNC_SHARE variable is set to " + s + "; should be yes or no");
   }
+// the shared buffer is only used on request: each process still copies the positions
+// it needs in its own array, so that it does not save memory
+  if(std::getenv("PLUMED_SHARED_GATHER")) {
+    std::string s(std::getenv("PLUMED_SHARED_GATHER"));
+    if(s=="yes") {
+      plumed_massert(Communicator::hasSharedMemory(),"PLUMED_SHARED_GATHER=yes requires MPI-3");
+      shared=true;
+    }
+    else if(s=="no") shared=false;
+    else plumed_merror("PLUMED_SHARED_GATHER variable is set to " + s + "; should be yes or no");
+  }
+  if(std::getenv("PLUMED_OWNER_COMPUTES")) {
+    std::string s(std::getenv("PLUMED_OWNER_COMPUTES"));
+    if(s=="yes") ownerComputes=true;
+    else if(s=="no") ownerComputes=false;
+    else plumed_merror("PLUMED_OWNER_COMPUTES variable is set to " + s + "; should be yes or no");
+  }
+  if(shared) {
+    Split_shared(nodecomm);
+    Split(nodecomm.Get_rank()==0?0:1,Get_rank(),leadercomm);
+// shared gather is synchronous
+    async=false;
+  }
+}
+
+int Atoms::DomainDecomposition::gatherShared(int count,int ndata,int natoms,const int*&index,const double*&data) {
+// layout of the window: data (ndata doubles per atom), number of atoms, indexes
+  const size_t dataBytes=5*sizeof(double)*natoms;
+  const size_t bytes=dataBytes+sizeof(int)*(natoms+1);
+  if(window.size()<bytes) window.allocate(nodecomm,bytes);
+  double* sdata=static_cast<double*>(window.get());
+  int* stot=reinterpret_cast<int*>(static_cast<char*>(window.get())+dataBytes);
+  int* sindex=stot+1;
+
+// first gather on the node leader
+  const int nn=nodecomm.Get_size();
+  vector<int> counts(nn),displ(nn),countsd(nn),displd(nn);
+  nodecomm.Allgather(count,counts);
+  displ[0]=0;
+  for(int i=1; i<nn; ++i) displ[i]=displ[i-1]+counts[i-1];
+  for(int i=0; i<nn; ++i) countsd[i]=counts[i]*ndata;
+  for(int i=0; i<nn; ++i) displd[i]=displ[i]*ndata;
+  const int nodecount=displ[nn-1]+counts[nn-1];
+
+// Notice that the Gatherv on the leader can only complete when all the processes of the node
+// have entered this step, and thus finished reading the window in the previous one
+  if(nodecomm.Get_rank()==0) {
+    indexOnNode.resize(nodecount>0?nodecount:1);
+    positionsOnNode.resize(nodecount>0?ndata*nodecount:1);
+    nodecomm.Gatherv(&indexToBeSent[0],count,&indexOnNode[0],&counts[0],&displ[0],0);
+    nodecomm.Gatherv(&positionsToBeSent[0],ndata*count,&positionsOnNode[0],&countsd[0],&displd[0],0);
+// then exchange among leaders, writing directly on the window
+    const int nl=leadercomm.Get_size();
+    vector<int> lcounts(nl),ldispl(nl),lcountsd(nl),ldispld(nl);
+    leadercomm.Allgather(nodecount,lcounts);
+    ldispl[0]=0;
+    for(int i=1; i<nl; ++i) ldispl[i]=ldispl[i-1]+lcounts[i-1];
+    for(int i=0; i<nl; ++i) lcountsd[i]=lcounts[i]*ndata;
+    for(int i=0; i<nl; ++i) ldispld[i]=ldispl[i]*ndata;
+    leadercomm.Allgatherv(&indexOnNode[0],nodecount,sindex,&lcounts[0],&ldispl[0]);
+    leadercomm.Allgatherv(&positionsOnNode[0],ndata*nodecount,sdata,&lcountsd[0],&ldispld[0]);
+    *stot=ldispl[nl-1]+lcounts[nl-1];
+  } else {
+    nodecomm.Gatherv(&indexToBeSent[0],count,(int*)NULL,NULL,NULL,0);
+    nodecomm.Gatherv(&positionsToBeSent[0],ndata*count,(double*)NULL,NULL,NULL,0);
+  }
+  window.sync();
+  nodecomm.Barrier();
+  window.sync();
+
+  index=sindex;
+  data=sdata;
+  return *stot;
 }
 
 void Atoms::setAtomsNlocal(int n) {
@@ -408,7 +604,7 @@ void Atoms::setAtomsGatindex(int*g,bool fortran) {
     // keep in unique only those atoms that are local
     actions[i]->updateUniqueLocal();
   }
-  unique.clear();
+  clearUnique();
 }
 
 void Atoms::setAtomsContiguous(int start) {
@@ -421,7 +617,7 @@ void Atoms::setAtomsContiguous(int start) {
     // keep in unique only those atoms that are local
     actions[i]->updateUniqueLocal();
   }
-  unique.clear();
+  clearUnique();
 }
 
 void Atoms::setRealPrecision(int p) {
@@ -47,8 +47,18 @@ class Atoms
   friend class ActionAtomistic;
   friend class ActionWithVirtualAtom;
   int natoms;
+/// Atoms requested by the active actions, kept from step to step.
+/// It is rebuilt only when actions change their requests, when an action whose atoms
+/// were merged becomes inactive or when domain decomposition changes
   std::set<AtomNumber> unique;
+/// Local index of the atoms in unique, in the same order
   std::vector<unsigned> uniq_index;
+/// For each action, true if its atoms have already been merged into unique
+  std::vector<bool> uniqueMerged;
+/// Set when unique has been modified and uniq_index should be recomputed
+  bool uniqueChanged;
+/// Set when unique contains all the atoms because of shareAll(), and should be rebuilt at next share()
+  bool uniqueIsAll;
   std::vector<Vector> positions;
   std::vector<Vector> forces;
   std::vector<double> masses;
@@ -112,8 +122,20 @@ class Atoms
   public:
     bool on;
     bool async;
+/// if true, positions are gathered hierarchically through a buffer shared by the processes of each node.
+/// Only used with PLUMED_SHARED_GATHER=yes
+    bool shared;
+/// if true, actions allowing it are calculated only by the process owning most of their atoms
+    bool ownerComputes;
     std::vector<int>    g2l;
 
+/// processes on the same node
+    Communicator nodecomm;
+/// first process of each node (only meaningful on those processes)
+    Communicator leadercomm;
+/// positions and indexes gathered on the node, shared by all its processes
+    Communicator::SharedWindow window;
+
     std::vector<Communicator::Request> mpi_request_positions;
     std::vector<Communicator::Request> mpi_request_index;
 
@@ -121,17 +143,41 @@ class Atoms
     std::vector<double> positionsToBeReceived;
     std::vector<int>    indexToBeSent;
     std::vector<int>    indexToBeReceived;
+    std::vector<double> positionsOnNode;
+    std::vector<int>    indexOnNode;
+/// atoms that should be sent to each process in owner-computes mode
+    std::vector<std::vector<int> > indexToOwner;
     operator bool() const {return on;}
     DomainDecomposition():
-      on(false), async(false)
+      on(false), async(false), shared(false), ownerComputes(false)
     {}
     void enable(Communicator& c);
+/// Gather the sent data on the node leaders, exchange it among them and make it visible
+/// to all the processes of the node through the shared window.
+/// Returns the number of gathered atoms, and sets the pointers to the shared index and data.
+    int gatherShared(int count,int ndata,int natoms,const int*&index,const double*&data);
   };
 
   DomainDecomposition dd;
   long int ddStep;  //last step in which dd happened
 
   void share(const std::set<AtomNumber>&);
+/// Local atoms that are gathered on all the processes.
+/// In owner-computes mode, it excludes the atoms only needed by actions run on their owner
+  std::set<AtomNumber> uniqueGathered;
+/// Set when positions are distributed in owner-computes mode in the present step
+  bool ownerStep;
+/// Decide which process calculates each action that can run on its owner, and which atoms should be sent to it
+  void shareOwners();
+/// Send atoms to the processes owning the actions that use them
+  void exchangeOwned(int ndata);
+/// Empty unique, so that it is rebuilt at next share().
+/// Forces on the removed atoms are zeroed, so that all the atoms not in unique have zero force
+  void clearUnique();
+/// Check if positions and forces of all the atoms should be transferred at once.
+/// This is faster than using uniq_index when most of the atoms are requested,
+/// and is required when actions access global forces
+  bool shareAllAtoms()const;
 
 public:
 
@@ -72,25 +72,28 @@ void Colvar::apply() {
     {
       vector<Vector> omp_f(fsz);
       Tensor         omp_v;
-      vector<double> forces(3*nat+9);
+      vector<double> forces(3*nat+9,0.0);
+      bool at_least_one_forced=false;
+// the forces of all the components are summed first, so that values with sparse derivatives only touch the atoms they depend on
       #pragma omp for
       for(unsigned i=rank; i<ncp; i+=stride) {
-        if(getPntrToComponent(i)->applyForce(forces)) {
-          for(unsigned j=0; j<nat; ++j) {
-            omp_f[j][0]+=forces[3*j+0];
-            omp_f[j][1]+=forces[3*j+1];
-            omp_f[j][2]+=forces[3*j+2];
-          }
-          omp_v(0,0)+=forces[3*nat+0];
-          omp_v(0,1)+=forces[3*nat+1];
-          omp_v(0,2)+=forces[3*nat+2];
-          omp_v(1,0)+=forces[3*nat+3];
-          omp_v(1,1)+=forces[3*nat+4];
-          omp_v(1,2)+=forces[3*nat+5];
-          omp_v(2,0)+=forces[3*nat+6];
-          omp_v(2,1)+=forces[3*nat+7];
-          omp_v(2,2)+=forces[3*nat+8];
+        if(getPntrToComponent(i)->accumulateForces(forces)) at_least_one_forced=true;
+      }
+      if(at_least_one_forced) {
+        for(unsigned j=0; j<nat; ++j) {
+          omp_f[j][0]+=forces[3*j+0];
+          omp_f[j][1]+=forces[3*j+1];
+          omp_f[j][2]+=forces[3*j+2];
         }
+        omp_v(0,0)+=forces[3*nat+0];
+        omp_v(0,1)+=forces[3*nat+1];
+        omp_v(0,2)+=forces[3*nat+2];
+        omp_v(1,0)+=forces[3*nat+3];
+        omp_v(1,1)+=forces[3*nat+4];
+        omp_v(1,2)+=forces[3*nat+5];
+        omp_v(2,0)+=forces[3*nat+6];
+        omp_v(2,1)+=forces[3*nat+7];
+        omp_v(2,2)+=forces[3*nat+8];
       }
       #pragma omp critical
       {
@@ -113,10 +116,20 @@ void Colvar::apply() {
 void Colvar::setBoxDerivativesNoPbc(Value* v) {
   Tensor virial;
   unsigned nat=getNumberOfAtoms();
-  for(unsigned i=0; i<nat; i++) virial-=Tensor(getPosition(i),
-                                          Vector(v->getDerivative(3*i+0),
-                                              v->getDerivative(3*i+1),
-                                              v->getDerivative(3*i+2)));
+  if(v->hasSparseDerivatives()) {
+// only the atoms with a derivative contribute
+    for(unsigned j=0; j<v->getNumberActive(); j++) {
+      const unsigned k=v->getActiveIndex(j);
+      if(k>=3*nat) break;
+      const Vector & pos(getPosition(k/3));
+      for(unsigned l=0; l<3; l++) virial(l,k%3)-=pos[l]*v->getActiveDerivative(j);
+    }
+  } else {
+    for(unsigned i=0; i<nat; i++) virial-=Tensor(getPosition(i),
+                                            Vector(v->getDerivative(3*i+0),
+                                                v->getDerivative(3*i+1),
+                                                v->getDerivative(3*i+2)));
+  }
   setBoxDerivatives(v,virial);
 }
 }
@@ -23,6 +23,7 @@
 #include "ActionAtomistic.h"
 #include "ActionPilot.h"
 #include "ActionRegister.h"
+#include "ActionScheduler.h"
 #include "ActionSet.h"
 #include "ActionWithValue.h"
 #include "ActionWithVirtualAtom.h"
@@ -40,10 +41,15 @@
 #include "tools/OpenMP.h"
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
+#include "tools/Profiler.h"
+#include "tools/AsyncWriter.h"
+#include "tools/OFile.h"
 #include <cstdlib>
 #include <cstring>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
+#include <system_error>
 
 using namespace std;
 
@@ -84,8 +90,14 @@ PlumedMain::PlumedMain():
   doCheckPoint(false),
   stopFlag(NULL),
   stopNow(false),
+  plannedActions(*new std::vector<PlannedAction>),
+  activeActions(*new std::vector<PlannedAction>),
+  scheduler(*new ActionScheduler),
   novirial(false),
-  detailedTimers(false)
+  detailedTimers(false),
+  parallelActions(false),
+  profiler(NULL),
+  asyncWriter(NULL)
 {
   log.link(comm);
   log.setLinePrefix("PLUMED: ");
@@ -98,7 +110,18 @@ PlumedMain::~PlumedMain() {
   stopwatch.stop();
   if(initialized) log<<stopwatch;
   delete &exchangePatterns;
+  delete &scheduler;
+  delete &activeActions;
+  delete &plannedActions;
   delete &actionSet;
+  if(asyncWriter) {
+// files that are still open are written directly from now on
+    for(const auto & f : files) {
+      OFile* of=dynamic_cast<OFile*>(f);
+      if(of) of->setAsyncWriter(NULL);
+    }
+    delete asyncWriter;
+  }
   delete &citations;
   delete &atoms;
   delete &log;
@@ -272,6 +295,8 @@ void PlumedMain::cmd(const std::string & word,void*val) {
       break;
     case cmd_clear:
       CHECK_INIT(initialized,word);
+      activeActions.clear();
+      plannedActions.clear();
       actionSet.clearDelete();
       break;
     case cmd_getApiVersion:
@@ -487,6 +512,19 @@ void PlumedMain::init() {
   log.printf("Number of atoms: %d\n",atoms.getNatoms());
   if(grex) log.printf("GROMACS-like replica exchange is on\n");
   log.printf("File suffix: %s\n",getSuffix().c_str());
+// the size of the buffer is taken from the root process, so that all the processes agree on it
+  int asyncSize=0;
+  if(comm.Get_rank()==0 && std::getenv("PLUMED_ASYNC_OUTPUT")) Tools::convert(std::getenv("PLUMED_ASYNC_OUTPUT"),asyncSize);
+  comm.Bcast(asyncSize,0);
+  if(asyncSize>0) {
+    try {
+      asyncWriter=new AsyncWriter(1024*static_cast<std::size_t>(asyncSize));
+      log.printf("Output files are written in the background with a buffer of %d kB\n",asyncSize);
+    } catch(const std::system_error&) {
+// threads might not be available, e.g. if plumed was linked without -pthread
+      log.printf("WARNING: cannot start the thread writing output files, they are written directly\n");
+    }
+  }
   if(plumedDat.length()>0) {
     readInputFile(plumedDat);
     plumedDat="";
@@ -554,6 +592,7 @@ void PlumedMain::readInputWords(const std::vector<std::string> & words) {
     };
     action->checkRead();
     actionSet.push_back(action);
+    plannedActions.push_back(PlannedAction(action,plannedActions.size()));
   };
 
   pilots=actionSet.select<ActionPilot*>();
@@ -585,7 +624,7 @@ void PlumedMain::prepareCalc() {
 // traverse them in this order:
 void PlumedMain::prepareDependencies() {
 
-  stopwatch.start("1 Prepare dependencies");
+  startTimer("1 Prepare dependencies");
 
 // activate all the actions which are on step
 // activation is recursive and enables also the dependencies
@@ -614,15 +653,19 @@ void PlumedMain::prepareDependencies() {
     }
   }
 
-  stopwatch.stop("1 Prepare dependencies");
+// the active actions are stored, so that the forward and backward loops do not need to check all the actions
+  activeActions.clear();
+  for(const auto & p : plannedActions) if(p.action->isActive()) activeActions.push_back(p);
+
+  stopTimer("1 Prepare dependencies");
 }
 
 void PlumedMain::shareData() {
 // atom positions are shared (but only if there is something to do)
   if(!active)return;
-  stopwatch.start("2 Sharing data");
+  startTimer("2 Sharing data");
   if(atoms.getNatoms()>0) atoms.share();
-  stopwatch.stop("2 Sharing data");
+  stopTimer("2 Sharing data");
 }
 
 void PlumedMain::performCalcNoUpdate() {
@@ -640,50 +683,77 @@ void PlumedMain::performCalc() {
 
 void PlumedMain::waitData() {
   if(!active)return;
-  stopwatch.start("3 Waiting for data");
+  startTimer("3 Waiting for data");
   if(atoms.getNatoms()>0) atoms.wait();
-  stopwatch.stop("3 Waiting for data");
+  stopTimer("3 Waiting for data");
 }
 
 void PlumedMain::justCalculate() {
   if(!active)return;
-  stopwatch.start("4 Calculating (forward loop)");
+  startTimer("4 Calculating (forward loop)");
   bias=0.0;
   work=0.0;
 
-  int iaction=0;
+  if(useScheduler()) {
+// actions are calculated as soon as the ones they depend on are done, the bias is then summed in order
+    scheduler.calculate(activeActions,OpenMP::getNumThreads());
+    for(const auto & p : activeActions) {
+      if(p.bias) bias+=p.bias->get();
+      if(p.work) work+=p.work->get();
+    }
+    stopTimer("4 Calculating (forward loop)");
+    return;
+  }
+
+// actions calculated only by their owner are summed over the processes in a single reduction,
+// which is done before an action that depends on one of them is calculated
+  std::vector<const PlannedAction*> owned;
+  std::unordered_set<const Action*> ownedSet;
 // calculate the active actions in order (assuming *backward* dependence)
-  for(const auto & p : actionSet) {
-    if(p->isActive()) {
-      std::string actionNumberLabel;
-      if(detailedTimers) {
-        Tools::convert(iaction,actionNumberLabel);
-        actionNumberLabel="4A "+actionNumberLabel+" "+p->getLabel();
-        stopwatch.start(actionNumberLabel);
-      }
-      ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
-      ActionAtomistic*aa=dynamic_cast<ActionAtomistic*>(p);
-      {
-        if(av) av->clearInputForces();
-        if(av) av->clearDerivatives();
-      }
-      {
-        if(aa) aa->clearOutputForces();
-        if(aa) if(aa->isActive()) aa->retrieveAtoms();
-      }
-      if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
-      else p->calculate();
-      // This retrieves components called bias
-      if(av) bias+=av->getOutputQuantity("bias");
-      if(av) work+=av->getOutputQuantity("work");
-      if(av)av->setGradientsIfNeeded();
-      ActionWithVirtualAtom*avv=dynamic_cast<ActionWithVirtualAtom*>(p);
-      if(avv)avv->setGradientsIfNeeded();
-      if(detailedTimers) stopwatch.stop(actionNumberLabel);
+  for(const auto & p : activeActions) {
+    if(!owned.empty()) {
+      const Action::Dependencies & deps( p.action->getDependencies() );
+      for(unsigned j=0; j<deps.size(); ++j) if(ownedSet.count(deps[j])) { sumOwnedActions(owned); ownedSet.clear(); break; }
+    }
+    std::string actionNumberLabel;
+    if(detailedTimers || profiler) {
+      Tools::convert(p.index,actionNumberLabel);
+      actionNumberLabel="4A "+actionNumberLabel+" "+p.action->getLabel();
+      if(detailedTimers) stopwatch.start(actionNumberLabel);
+      if(profiler) profiler->start(actionNumberLabel);
     }
-    iaction++;
+    ActionScheduler::calculateAction(p);
+    if(p.aa && p.av && p.aa->isRunOnOwner()) { owned.push_back(&p); ownedSet.insert(p.action); }
+    if(detailedTimers) stopwatch.stop(actionNumberLabel);
+    if(profiler) profiler->stop(actionNumberLabel);
   }
-  stopwatch.stop("4 Calculating (forward loop)");
+  if(!owned.empty()) sumOwnedActions(owned);
+  for(const auto & p : activeActions) {
+    // This retrieves components called bias
+    if(p.bias) bias+=p.bias->get();
+    if(p.work) work+=p.work->get();
+  }
+  stopTimer("4 Calculating (forward loop)");
+}
+
+void PlumedMain::sumOwnedActions(std::vector<const PlannedAction*>& owned) {
+  std::vector<double> buffer;
+  for(const auto & p : owned) p->av->addToSumBuffer(buffer,p->aa->isOwner());
+  comm.Sum(buffer);
+  unsigned k=0;
+  for(const auto & p : owned) {
+    p->av->retrieveFromSumBuffer(buffer,k);
+    // gradients are set from the summed derivatives
+    p->av->setGradientsIfNeeded();
+  }
+  owned.clear();
+}
+
+bool PlumedMain::useScheduler()const {
+// actions may communicate inside calculate() and apply(), and MPI calls cannot be made from many threads
+// at the same time, so actions are only run concurrently when MPI is not used at all.
+// the profiler needs the time spent in each action, so the actions are then run in order
+  return parallelActions && !profiler && OpenMP::getNumThreads()>1 && !Communicator::initialized();
 }
 
 void PlumedMain::justApply() {
@@ -693,41 +763,42 @@ void PlumedMain::justApply() {
 
 void PlumedMain::backwardPropagate() {
   if(!active)return;
-  int iaction=0;
-  stopwatch.start("5 Applying (backward loop)");
+  startTimer("5 Applying (backward loop)");
+  if(useScheduler()) {
+    scheduler.apply(activeActions,OpenMP::getNumThreads());
+  } else {
 // apply them in reverse order
-  for(auto pp=actionSet.rbegin(); pp!=actionSet.rend(); ++pp) {
-    const auto & p(*pp);
-    if(p->isActive()) {
+    for(auto pp=activeActions.rbegin(); pp!=activeActions.rend(); ++pp) {
+      const auto & p(*pp);
 
       std::string actionNumberLabel;
-      if(detailedTimers) {
-        Tools::convert(iaction,actionNumberLabel);
-        actionNumberLabel="5A "+actionNumberLabel+" "+p->getLabel();
-        stopwatch.start(actionNumberLabel);
+      if(detailedTimers || profiler) {
+        Tools::convert(plannedActions.size()-1-p.index,actionNumberLabel);
+        actionNumberLabel="5A "+actionNumberLabel+" "+p.action->getLabel();
+        if(detailedTimers) stopwatch.start(actionNumberLabel);
+        if(profiler) profiler->start(actionNumberLabel);
       }
 
-      p->apply();
-      ActionAtomistic*a=dynamic_cast<ActionAtomistic*>(p);
-// still ActionAtomistic has a special treatment, since they may need to add forces on atoms
-      if(a) a->applyForces();
+      ActionScheduler::applyAction(p);
 
       if(detailedTimers) stopwatch.stop(actionNumberLabel);
+      if(profiler) profiler->stop(actionNumberLabel);
     }
-    iaction++;
   }
 
 // this is updating the MD copy of the forces
   if(detailedTimers) stopwatch.start("5B Update forces");
+  if(profiler) profiler->start("5B Update forces");
   if(atoms.getNatoms()>0) atoms.updateForces();
+  if(profiler) profiler->stop("5B Update forces");
   if(detailedTimers) stopwatch.stop("5B Update forces");
-  stopwatch.stop("5 Applying (backward loop)");
+  stopTimer("5 Applying (backward loop)");
 }
 
 void PlumedMain::update() {
   if(!active)return;
 
-  stopwatch.start("6 Update");
+  startTimer("6 Update");
 // update step (for statistics, etc)
   updateFlags.push(true);
   for(const auto & p : actionSet) {
@@ -750,7 +821,17 @@ void PlumedMain::update() {
     log.flush();
     for(const auto & p : actionSet) p->fflush();
   }
-  stopwatch.stop("6 Update");
+  stopTimer("6 Update");
+}
+
+void PlumedMain::startTimer(const std::string& name) {
+  stopwatch.start(name);
+  if(profiler) profiler->start(name);
+}
+
+void PlumedMain::stopTimer(const std::string& name) {
+  if(profiler) profiler->stop(name);
+  stopwatch.stop(name);
 }
 
 void PlumedMain::load(const std::string& ss) {
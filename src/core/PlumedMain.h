@@ -58,9 +58,13 @@ class ActionSet;
 class DLLoader;
 class Communicator;
 class Stopwatch;
+class Profiler;
+class AsyncWriter;
 class Citations;
 class ExchangePatterns;
 class FileBase;
+class ActionScheduler;
+class PlannedAction;
 
 /**
 Main plumed object.
@@ -150,6 +154,24 @@ private:
 /// Store information used in class \ref generic::UpdateIf
   std::stack<bool> updateFlags;
 
+/// The actions in actionSet with the pointers used to run them, set when the actions are created
+  std::vector<PlannedAction>& plannedActions;
+/// The actions that are active at this step in the order of the input, set in prepareDependencies()
+  std::vector<PlannedAction>& activeActions;
+
+/// Scheduler used to run independent actions concurrently
+  ActionScheduler& scheduler;
+/// Are the actions run concurrently by the scheduler at this step
+  bool useScheduler()const;
+/// Sum over the processes the values of actions calculated only by their owner (see ActionAtomistic::allowRunOnOwner()).
+/// This is done in a single reduction for all the actions in the list, which is then emptied
+  void sumOwnedActions(std::vector<const PlannedAction*>& owned);
+
+/// Start a timer of the main loop, also in the profiler if present
+  void startTimer(const std::string&);
+/// Stop a timer of the main loop, also in the profiler if present
+  void stopTimer(const std::string&);
+
 public:
 /// Flag to switch off virial calculation (for debug and MD codes with no barostat)
   bool novirial;
@@ -157,6 +179,15 @@ public:
 /// Flag to switch on detailed timers
   bool detailedTimers;
 
+/// Flag to run actions that do not depend on each other concurrently, set with \ref DEBUG
+  bool parallelActions;
+
+/// Profiler collecting timings and counters, set when profiling is requested with \ref PROFILE
+  Profiler* profiler;
+
+/// Writer used to write the output files in the background, NULL unless PLUMED_ASYNC_OUTPUT is set
+  AsyncWriter* asyncWriter;
+
 /// Add a citation, returning a string containing the reference number, something like "[10]"
   std::string cite(const std::string&);
 
@@ -36,6 +36,8 @@ Value::Value():
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparse(false),
+  nderivatives(0),
   hasDeriv(true),
   periodicity(unset),
   min(0.0),
@@ -51,6 +53,8 @@ Value::Value(ActionWithValue* av, const std::string& name, const bool withderiv)
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparse(false),
+  nderivatives(0),
   name(name),
   hasDeriv(withderiv),
   periodicity(unset),
@@ -79,12 +83,47 @@ bool Value::isPeriodic()const {
 
 bool Value::applyForce(std::vector<double>& forces ) const {
   if( !hasForce ) return false;
-  plumed_dbg_massert( derivatives.size()==forces.size()," forces array has wrong size" );
+  plumed_dbg_massert( nderivatives==forces.size()," forces array has wrong size" );
   const unsigned N=derivatives.size();
-  for(unsigned i=0; i<N; ++i) forces[i]=inputForce*derivatives[i];
+  if( sparse ) {
+    std::fill(forces.begin(), forces.end(), 0);
+    for(unsigned j=0; j<N; ++j) forces[derivativeIndices[j]]=inputForce*derivatives[j];
+  } else {
+    for(unsigned i=0; i<N; ++i) forces[i]=inputForce*derivatives[i];
+  }
+  return true;
+}
+
+bool Value::accumulateForces(std::vector<double>& forces ) const {
+  if( !hasForce ) return false;
+  plumed_dbg_massert( nderivatives==forces.size()," forces array has wrong size" );
+  const unsigned N=derivatives.size();
+  if( sparse ) {
+    for(unsigned j=0; j<N; ++j) forces[derivativeIndices[j]]+=inputForce*derivatives[j];
+  } else {
+    for(unsigned i=0; i<N; ++i) forces[i]+=inputForce*derivatives[i];
+  }
   return true;
 }
 
+void Value::setSparseDerivatives(const bool& s) {
+  if( !hasDeriv || s==sparse ) return;
+  if( s ) {
+    // only the non-zero derivatives are kept
+    std::vector<double> dense; dense.swap(derivatives);
+    derivativeIndices.resize(0);
+    for(unsigned i=0; i<dense.size(); ++i) {
+      if( dense[i]!=0 ) { derivativeIndices.push_back(i); derivatives.push_back(dense[i]); }
+    }
+  } else {
+    std::vector<double> dense(nderivatives,0.0);
+    for(unsigned j=0; j<derivatives.size(); ++j) dense[derivativeIndices[j]]=derivatives[j];
+    derivatives.swap(dense);
+    derivativeIndices.resize(0);
+  }
+  sparse=s;
+}
+
 void Value::setNotPeriodic() {
   min=0; max=0; periodicity=notperiodic;
 }
@@ -123,18 +162,19 @@ void Value::setGradients() {
         const ActionWithVirtualAtom* a=atoms.getVirtualAtomsAction(an);
         for(const auto & p : a->getGradients()) {
 // controllare l'ordine del matmul:
-          gradients[p.first]+=matmul(Vector(derivatives[3*j],derivatives[3*j+1],derivatives[3*j+2]),p.second);
+          gradients[p.first]+=matmul(Vector(getDerivative(3*j),getDerivative(3*j+1),getDerivative(3*j+2)),p.second);
         }
       } else {
-        for(unsigned i=0; i<3; i++) gradients[an][i]+=derivatives[3*j+i];
+        for(unsigned i=0; i<3; i++) gradients[an][i]+=getDerivative(3*j+i);
       }
     }
   } else if(aw) {
     std::vector<Value*> values=aw->getArguments();
-    for(unsigned j=0; j<derivatives.size(); j++) {
+    for(unsigned k=0; k<getNumberActive(); k++) {
+      const unsigned j=getActiveIndex(k);
       for(const auto & p : values[j]->gradients) {
         AtomNumber iatom=p.first;
-        gradients[iatom]+=p.second*derivatives[j];
+        gradients[iatom]+=p.second*derivatives[k];
       }
     }
   } else plumed_error();
@@ -163,7 +203,7 @@ void copy( const Value& val1, Value& val2 ) {
   unsigned nder=val1.getNumberOfDerivatives();
   if( nder!=val2.getNumberOfDerivatives() ) { val2.resizeDerivatives( nder ); }
   val2.clearDerivatives();
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2.addDerivative( i, val1.getDerivative(i) );
+  for(unsigned j=0; j<val1.getNumberActive(); ++j) val2.addDerivative( val1.getActiveIndex(j), val1.getActiveDerivative(j) );
   val2.set( val1.get() );
 }
 
@@ -171,13 +211,13 @@ void copy( const Value& val1, Value* val2 ) {
   unsigned nder=val1.getNumberOfDerivatives();
   if( nder!=val2->getNumberOfDerivatives() ) { val2->resizeDerivatives( nder ); }
   val2->clearDerivatives();
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2->addDerivative( i, val1.getDerivative(i) );
+  for(unsigned j=0; j<val1.getNumberActive(); ++j) val2->addDerivative( val1.getActiveIndex(j), val1.getActiveDerivative(j) );
   val2->set( val1.get() );
 }
 
 void add( const Value& val1, Value* val2 ) {
   plumed_assert( val1.getNumberOfDerivatives()==val2->getNumberOfDerivatives() );
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) val2->addDerivative( i, val1.getDerivative(i) );
+  for(unsigned j=0; j<val1.getNumberActive(); ++j) val2->addDerivative( val1.getActiveIndex(j), val1.getActiveDerivative(j) );
   val2->set( val1.get() + val2->get() );
 }
 
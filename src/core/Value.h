@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <algorithm>
 #include "tools/Exception.h"
 #include "tools/Tools.h"
 #include "tools/AtomNumber.h"
@@ -67,7 +68,16 @@ private:
 /// A flag telling us we have a force acting on this quantity
   bool hasForce;
 /// The derivatives of the quantity stored in value
+/// (if the derivatives are sparse only the ones with the indices in derivativeIndices are stored)
   std::vector<double> derivatives;
+/// Are only the derivatives that have been set stored
+  bool sparse;
+/// The number of derivatives
+  unsigned nderivatives;
+/// The indices of the derivatives that are stored when the derivatives are sparse (in increasing order)
+  std::vector<unsigned> derivativeIndices;
+/// Get a reference to the stored derivative with index i (it is added if it is not there)
+  double& getSparseDerivative(unsigned i);
   std::map<AtomNumber,Vector> gradients;
 /// The name of this quantiy
   std::string name;
@@ -115,6 +125,16 @@ public:
   unsigned getNumberOfDerivatives() const;
 /// Set the number of derivatives
   void resizeDerivatives(int n);
+/// Store only the derivatives that are set rather than the full array, which saves memory and time if few of them are non-zero
+  void setSparseDerivatives(const bool& s);
+/// Are only the derivatives that are set stored
+  bool hasSparseDerivatives() const ;
+/// Get the number of derivatives that are stored (all of them if the derivatives are not sparse)
+  unsigned getNumberActive() const ;
+/// Get the index of the jth stored derivative
+  unsigned getActiveIndex(const unsigned& j) const ;
+/// Get the value of the jth stored derivative
+  double getActiveDerivative(const unsigned& j) const ;
 /// Set all the derivatives to zero
   void clearDerivatives();
 /// Add some derivative to the ith component of the derivatives array
@@ -133,6 +153,8 @@ public:
   double getForce() const ;
 /// Apply the forces to the derivatives using the chain rule (if there are no forces this routine returns false)
   bool applyForce( std::vector<double>& forces ) const ;
+/// Add the forces on the derivatives to forces, only looping over the stored derivatives (if there are no forces this routine returns false)
+  bool accumulateForces( std::vector<double>& forces ) const ;
 /// Calculate the difference between the instantaneous value of the function and some other point: other_point-inst_val
   double difference(double)const;
 /// Calculate the difference between two values of this function: d2 -d1
@@ -160,29 +182,27 @@ void Value::applyPeriodicity() {
 
 inline
 void product( const Value& val1, const Value& val2, Value& valout ) {
-  plumed_assert( val1.derivatives.size()==val2.derivatives.size() );
-  if( valout.derivatives.size()!=val1.derivatives.size() ) valout.resizeDerivatives( val1.derivatives.size() );
+  plumed_assert( val1.nderivatives==val2.nderivatives );
+  if( valout.nderivatives!=val1.nderivatives ) valout.resizeDerivatives( val1.nderivatives );
   valout.value_set=false;
   valout.clearDerivatives();
   double u=val1.value;
   double v=val2.value;
-  for(unsigned i=0; i<val1.derivatives.size(); ++i) {
-    valout.addDerivative(i, u*val2.derivatives[i] + v*val1.derivatives[i] );
-  }
+  for(unsigned j=0; j<val1.getNumberActive(); ++j) valout.addDerivative(val1.getActiveIndex(j), v*val1.getActiveDerivative(j) );
+  for(unsigned j=0; j<val2.getNumberActive(); ++j) valout.addDerivative(val2.getActiveIndex(j), u*val2.getActiveDerivative(j) );
   valout.set( u*v );
 }
 
 inline
 void quotient( const Value& val1, const Value& val2, Value* valout ) {
-  plumed_assert( val1.derivatives.size()==val2.derivatives.size() );
-  if( valout->derivatives.size()!=val1.derivatives.size() ) valout->resizeDerivatives( val1.derivatives.size() );
+  plumed_assert( val1.nderivatives==val2.nderivatives );
+  if( valout->nderivatives!=val1.nderivatives ) valout->resizeDerivatives( val1.nderivatives );
   valout->value_set=false;
   valout->clearDerivatives();
   double u=val1.get();
   double v=val2.get();
-  for(unsigned i=0; i<val1.getNumberOfDerivatives(); ++i) {
-    valout->addDerivative(i, v*val1.getDerivative(i) - u*val2.getDerivative(i) );
-  }
+  for(unsigned j=0; j<val1.getNumberActive(); ++j) valout->addDerivative(val1.getActiveIndex(j), v*val1.getActiveDerivative(j) );
+  for(unsigned j=0; j<val2.getNumberActive(); ++j) valout->addDerivative(val2.getActiveIndex(j), -u*val2.getActiveDerivative(j) );
   valout->chainRule( 1/(v*v) ); valout->set( u / v );
 }
 
@@ -218,13 +238,54 @@ const std::string& Value::getName()const {
 inline
 unsigned Value::getNumberOfDerivatives() const {
   plumed_massert(hasDeriv,"the derivatives array for this value has zero size");
-  return derivatives.size();
+  return nderivatives;
 }
 
 inline
 double Value::getDerivative(const unsigned n) const {
-  plumed_dbg_massert(n<derivatives.size(),"you are asking for a derivative that is out of bounds");
-  return derivatives[n];
+  plumed_dbg_massert(n<nderivatives,"you are asking for a derivative that is out of bounds");
+  if( !sparse ) return derivatives[n];
+  std::vector<unsigned>::const_iterator it=std::lower_bound( derivativeIndices.begin(), derivativeIndices.end(), n );
+  if( it==derivativeIndices.end() || *it!=n ) return 0.0;
+  return derivatives[it-derivativeIndices.begin()];
+}
+
+inline
+bool Value::hasSparseDerivatives() const {
+  return sparse;
+}
+
+inline
+unsigned Value::getNumberActive() const {
+  return derivatives.size();
+}
+
+inline
+unsigned Value::getActiveIndex(const unsigned& j) const {
+  plumed_dbg_massert(j<derivatives.size(),"you are asking for a derivative that is out of bounds");
+  if( !sparse ) return j;
+  return derivativeIndices[j];
+}
+
+inline
+double Value::getActiveDerivative(const unsigned& j) const {
+  plumed_dbg_massert(j<derivatives.size(),"you are asking for a derivative that is out of bounds");
+  return derivatives[j];
+}
+
+inline
+double& Value::getSparseDerivative(unsigned i) {
+// derivatives are usually added in increasing order, so new ones can be added at the end
+  if( derivativeIndices.empty() || derivativeIndices.back()<i ) {
+    derivativeIndices.push_back(i); derivatives.push_back(0.0);
+    return derivatives.back();
+  }
+  std::vector<unsigned>::iterator it=std::lower_bound( derivativeIndices.begin(), derivativeIndices.end(), i );
+  const unsigned j=it-derivativeIndices.begin();
+  if( *it!=i ) {
+    derivativeIndices.insert(it,i); derivatives.insert(derivatives.begin()+j,0.0);
+  }
+  return derivatives[j];
 }
 
 inline
@@ -234,19 +295,26 @@ bool Value::hasDerivatives() const {
 
 inline
 void Value::resizeDerivatives(int n) {
-  if(hasDeriv) derivatives.resize(n);
+  if(!hasDeriv) return;
+  nderivatives=n;
+  if(!sparse) { derivatives.resize(n); return; }
+// the derivatives with an index that is out of bounds are removed
+  const unsigned nactive=std::lower_bound( derivativeIndices.begin(), derivativeIndices.end(), nderivatives )-derivativeIndices.begin();
+  derivativeIndices.resize(nactive); derivatives.resize(nactive);
 }
 
 inline
 void Value::addDerivative(unsigned i,double d) {
-  plumed_dbg_massert(i<derivatives.size(),"derivative is out of bounds");
-  derivatives[i]+=d;
+  plumed_dbg_massert(i<nderivatives,"derivative is out of bounds");
+  if(sparse) getSparseDerivative(i)+=d;
+  else derivatives[i]+=d;
 }
 
 inline
 void Value::setDerivative(unsigned i, double d) {
-  plumed_dbg_massert(i<derivatives.size(),"derivative is out of bounds");
-  derivatives[i]=d;
+  plumed_dbg_massert(i<nderivatives,"derivative is out of bounds");
+  if(sparse) getSparseDerivative(i)=d;
+  else derivatives[i]=d;
 }
 
 inline
@@ -263,7 +331,8 @@ void Value::clearInputForce() {
 inline
 void Value::clearDerivatives() {
   value_set=false;
-  std::fill(derivatives.begin(), derivatives.end(), 0);
+  if(sparse) { derivativeIndices.resize(0); derivatives.resize(0); }
+  else std::fill(derivatives.begin(), derivatives.end(), 0);
 }
 
 inline
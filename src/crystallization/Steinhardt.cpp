@@ -21,7 +21,6 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "Steinhardt.h"
 #include "core/PlumedMain.h"
-#include <complex>
 
 namespace PLMD {
 namespace crystallization {
@@ -67,83 +66,124 @@ Steinhardt::Steinhardt( const ActionOptions& ao ):
 
 void Steinhardt::setAngularMomentum( const unsigned& ang ) {
   tmom=ang; setVectorDimensionality( 2*(2*ang + 1) );
+
+  std::vector<double> fact( 2*tmom+1 ); fact[0]=1.0;
+  for(unsigned i=1; i<fact.size(); ++i) fact[i]=i*fact[i-1];
+  // Coefficients of the Legendre polynomial of order tmom
+  std::vector<double> legendre( tmom+1, 0.0 );
+  for(unsigned k=0; 2*k<=tmom; ++k) {
+    double sign=( k%2==0 ? 1.0 : -1.0 );
+    legendre[tmom-2*k] = sign*fact[2*tmom-2*k] / ( std::pow( 2.0, static_cast<double>(tmom) )*fact[k]*fact[tmom-k]*fact[tmom-2*k] );
+  }
+  // The spherical harmonic for m is the mth derivative of the Legendre polynomial times ((x+iy)/r)^m
+  // and the normalization (-1)^m sqrt( ((2l+1)*(l-m)!) / (4*pi*(l+m)!) )
+  poly_coeff.resize( tmom+1 ); dpoly_coeff.resize( tmom+1 );
+  for(unsigned m=0; m<=tmom; ++m) {
+    double normaliz = ( m%2==0 ? 1.0 : -1.0 )*sqrt( ( (2*tmom+1)*fact[tmom-m] ) / ( 4.0*pi*fact[tmom+m] ) );
+    poly_coeff[m].resize( tmom-m+1 ); dpoly_coeff[m].assign( tmom-m+1, 0.0 );
+    for(unsigned j=0; j<=tmom-m; ++j) poly_coeff[m][j] = normaliz*legendre[m+j]*fact[m+j]/fact[j];
+    for(unsigned j=1; j<=tmom-m; ++j) dpoly_coeff[m][j-1] = j*poly_coeff[m][j];
+  }
+}
+
+void Steinhardt::evaluatePolynomials( const unsigned& m, const unsigned& n, const double* z, double* poly, double* dpoly ) const {
+  const std::vector<double>& c( poly_coeff[m] ); const std::vector<double>& dc( dpoly_coeff[m] );
+  unsigned nc=c.size();
+  for(unsigned k=0; k<n; ++k) { poly[k]=c[nc-1]; dpoly[k]=dc[nc-1]; }
+  // Horner's method
+  for(int j=nc-2; j>=0; --j) {
+    for(unsigned k=0; k<n; ++k) { poly[k]=poly[k]*z[k]+c[j]; dpoly[k]=dpoly[k]*z[k]+dc[j]; }
+  }
 }
 
 void Steinhardt::calculateVector( multicolvar::AtomValuePack& myatoms ) const {
-  double dfunc, dpoly_ass, md, tq6, itq6, real_z, imag_z;
+  unsigned ncomp=2*tmom+1; bool doder=!doNotCalculateDerivatives();
   Vector dz, myrealvec, myimagvec, real_dz, imag_dz;
-  // The square root of -1
-  std::complex<double> ii( 0.0, 1.0 ), dp_x, dp_y, dp_z;
-
-  unsigned ncomp=2*tmom+1;
-  double sw, poly_ass, d2, dlen; std::complex<double> powered;
-  for(unsigned i=1; i<myatoms.getNumberOfAtoms(); ++i) {
-    Vector& distance=myatoms.getPosition(i);  // getSeparation( myatoms.getPosition(0), myatoms.getPosition(i) );
-    if ( (d2=distance[0]*distance[0])<rcut2 &&
-         (d2+=distance[1]*distance[1])<rcut2 &&
-         (d2+=distance[2]*distance[2])<rcut2 &&
-         d2>epsilon ) {
-
-      dlen = sqrt(d2);
-      sw = switchingFunction.calculate( dlen, dfunc );
-      accumulateSymmetryFunction( -1, i, sw, (+dfunc)*distance, (-dfunc)*Tensor( distance,distance ), myatoms );
-      double dlen3 = d2*dlen;
-      // Do stuff for m=0
-      poly_ass=deriv_poly( 0, distance[2]/dlen, dpoly_ass );
-      // Derivatives of z/r wrt x, y, z
-      dz = -( distance[2] / dlen3 )*distance; dz[2] += (1.0 / dlen);
-      // Derivative wrt to the vector connecting the two atoms
-      myrealvec = (+sw)*dpoly_ass*dz + poly_ass*(+dfunc)*distance;
-      // Accumulate the derivatives
-      accumulateSymmetryFunction( 2 + tmom, i, sw*poly_ass, myrealvec, Tensor( -myrealvec,distance ), myatoms );
-
-      // The complex number of which we have to take powers
-      std::complex<double> com1( distance[0]/dlen,distance[1]/dlen );
-      powered = std::complex<double>(1.0,0.0);
-
-      // Do stuff for all other m values
-      for(unsigned m=1; m<=tmom; ++m) {
-        // Calculate Legendre Polynomial
-        poly_ass=deriv_poly( m, distance[2]/dlen, dpoly_ass );
-        // Calculate power of complex number
-        // if(std::abs(com1)>epsilon) powered=pow(com1,m-1);
-        // else if(m==1) powered=std::complex<double>(1.,0);
-        // else powered = std::complex<double>(0.,0.);
-        // Real and imaginary parts of z
-        real_z = real(com1*powered); imag_z = imag(com1*powered );
-
-        // Calculate steinhardt parameter
-        tq6=poly_ass*real_z;   // Real part of steinhardt parameter
-        itq6=poly_ass*imag_z;  // Imaginary part of steinhardt parameter
-
-        // Derivatives wrt ( x/r + iy )^m
-        md=static_cast<double>(m);
-        dp_x = md*powered*( (1.0/dlen)-(distance[0]*distance[0])/dlen3-ii*(distance[0]*distance[1])/dlen3 );
-        dp_y = md*powered*( ii*(1.0/dlen)-(distance[0]*distance[1])/dlen3-ii*(distance[1]*distance[1])/dlen3 );
-        dp_z = md*powered*( -(distance[0]*distance[2])/dlen3-ii*(distance[1]*distance[2])/dlen3 );
 
-        // Derivatives of real and imaginary parts of above
-        real_dz[0] = real( dp_x ); real_dz[1] = real( dp_y ); real_dz[2] = real( dp_z );
-        imag_dz[0] = imag( dp_x ); imag_dz[1] = imag( dp_y ); imag_dz[2] = imag( dp_z );
+  unsigned block_atom[neighBlockSize];
+  double block_sw[neighBlockSize], block_dfunc[neighBlockSize], block_ilen[neighBlockSize], block_z[neighBlockSize];
+  double block_poly[neighBlockSize], block_dpoly[neighBlockSize];
+  // Real and imaginary parts of ((x+iy)/r)^m and of ((x+iy)/r)^(m-1)
+  double block_re[neighBlockSize], block_im[neighBlockSize], block_pre[neighBlockSize], block_pim[neighBlockSize];
+
+  unsigned i=1;
+  while( i<myatoms.getNumberOfAtoms() ) {
+    // Collect a block of neighbours that are within the cutoff
+    unsigned n=0; double d2;
+    for(; i<myatoms.getNumberOfAtoms() && n<neighBlockSize; ++i) {
+      Vector& distance=myatoms.getPosition(i);  // getSeparation( myatoms.getPosition(0), myatoms.getPosition(i) );
+      if ( (d2=distance[0]*distance[0])<rcut2 &&
+           (d2+=distance[1]*distance[1])<rcut2 &&
+           (d2+=distance[2]*distance[2])<rcut2 &&
+           d2>epsilon ) {
+        double dlen = sqrt(d2);
+        block_sw[n] = switchingFunction.calculate( dlen, block_dfunc[n] );
+        accumulateSymmetryFunction( -1, i, block_sw[n], (+block_dfunc[n])*distance, (-block_dfunc[n])*Tensor( distance,distance ), myatoms );
+        block_atom[n]=i; block_ilen[n]=1.0/dlen; block_z[n]=distance[2]/dlen;
+        block_pre[n]=1.0; block_pim[n]=0.0; n++;
+      }
+    }
 
-        // Complete derivative of steinhardt parameter
-        myrealvec = (+sw)*dpoly_ass*real_z*dz + (+dfunc)*distance*tq6 + (+sw)*poly_ass*real_dz;
-        myimagvec = (+sw)*dpoly_ass*imag_z*dz + (+dfunc)*distance*itq6 + (+sw)*poly_ass*imag_dz;
+    for(unsigned m=0; m<=tmom; ++m) {
+      evaluatePolynomials( m, n, block_z, block_poly, block_dpoly );
+      if( m>0 ) {
+        // Calculate the next power of the complex number (x+iy)/r
+        for(unsigned k=0; k<n; ++k) {
+          const Vector& distance=myatoms.getPosition(block_atom[k]);
+          double cx=distance[0]*block_ilen[k], cy=distance[1]*block_ilen[k];
+          block_re[k]=cx*block_pre[k]-cy*block_pim[k]; block_im[k]=cx*block_pim[k]+cy*block_pre[k];
+        }
+      }
+      for(unsigned k=0; k<n; ++k) {
+        unsigned iat=block_atom[k]; const Vector& distance=myatoms.getPosition(iat);
+        double sw=block_sw[k], dfunc=block_dfunc[k], poly_ass=block_poly[k];
+        if( m==0 ) {
+          if( doder ) {
+            // Derivatives of z/r wrt x, y, z
+            double ilen=block_ilen[k], ilen3=ilen*ilen*ilen;
+            dz = -( distance[2]*ilen3 )*distance; dz[2] += ilen;
+            // Derivative wrt to the vector connecting the two atoms
+            myrealvec = (+sw)*block_dpoly[k]*dz + poly_ass*(+dfunc)*distance;
+          }
+          accumulateSymmetryFunction( 2 + tmom, iat, sw*poly_ass, myrealvec, Tensor( -myrealvec,distance ), myatoms );
+          continue;
+        }
+        // Calculate steinhardt parameter
+        double real_z=block_re[k], imag_z=block_im[k];
+        double tq6=poly_ass*real_z;   // Real part of steinhardt parameter
+        double itq6=poly_ass*imag_z;  // Imaginary part of steinhardt parameter
+
+        if( doder ) {
+          double ilen=block_ilen[k], ilen3=ilen*ilen*ilen, md=static_cast<double>(m);
+          double pre=md*block_pre[k], pim=md*block_pim[k];
+          dz = -( distance[2]*ilen3 )*distance; dz[2] += ilen;
+          // Derivatives wrt ( x/r + iy )^m: m ((x+iy)/r)^(m-1) times the derivatives of (x+iy)/r
+          double ax=ilen-distance[0]*distance[0]*ilen3, bx=-distance[0]*distance[1]*ilen3;
+          double ay=-distance[0]*distance[1]*ilen3, by=ilen-distance[1]*distance[1]*ilen3;
+          double az=-distance[0]*distance[2]*ilen3, bz=-distance[1]*distance[2]*ilen3;
+          real_dz[0] = pre*ax - pim*bx; imag_dz[0] = pre*bx + pim*ax;
+          real_dz[1] = pre*ay - pim*by; imag_dz[1] = pre*by + pim*ay;
+          real_dz[2] = pre*az - pim*bz; imag_dz[2] = pre*bz + pim*az;
+
+          // Complete derivative of steinhardt parameter
+          myrealvec = (+sw)*block_dpoly[k]*real_z*dz + (+dfunc)*distance*tq6 + (+sw)*poly_ass*real_dz;
+          myimagvec = (+sw)*block_dpoly[k]*imag_z*dz + (+dfunc)*distance*itq6 + (+sw)*poly_ass*imag_dz;
+        }
 
         // Real part
-        accumulateSymmetryFunction( 2 + tmom + m, i, sw*tq6, myrealvec, Tensor( -myrealvec,distance ), myatoms );
+        accumulateSymmetryFunction( 2 + tmom + m, iat, sw*tq6, myrealvec, Tensor( -myrealvec,distance ), myatoms );
         // Imaginary part
-        accumulateSymmetryFunction( 2+ncomp+tmom+m, i, sw*itq6, myimagvec, Tensor( -myimagvec,distance ), myatoms );
-        // Store -m part of vector
-        double pref=pow(-1.0,m);
+        accumulateSymmetryFunction( 2+ncomp+tmom+m, iat, sw*itq6, myimagvec, Tensor( -myimagvec,distance ), myatoms );
         // -m part of vector is just +m part multiplied by (-1.0)**m and multiplied by complex
         // conjugate of Legendre polynomial
+        double pref=( m%2==0 ? 1.0 : -1.0 );
         // Real part
-        accumulateSymmetryFunction( 2+tmom-m, i, pref*sw*tq6, pref*myrealvec, pref*Tensor( -myrealvec,distance ), myatoms );
+        accumulateSymmetryFunction( 2+tmom-m, iat, pref*sw*tq6, pref*myrealvec, pref*Tensor( -myrealvec,distance ), myatoms );
         // Imaginary part
-        accumulateSymmetryFunction( 2+ncomp+tmom-m, i, -pref*sw*itq6, -pref*myimagvec, pref*Tensor( myimagvec,distance ), myatoms );
-        // Calculate next power of complex number
-        powered *= com1;
+        accumulateSymmetryFunction( 2+ncomp+tmom-m, iat, -pref*sw*itq6, -pref*myimagvec, pref*Tensor( myimagvec,distance ), myatoms );
+      }
+      if( m>0 ) {
+        for(unsigned k=0; k<n; ++k) { block_pre[k]=block_re[k]; block_pim[k]=block_im[k]; }
       }
     }
   }
@@ -153,22 +193,5 @@ void Steinhardt::calculateVector( multicolvar::AtomValuePack& myatoms ) const {
   for(unsigned i=0; i<getNumberOfComponentsInVector(); ++i) myatoms.getUnderlyingMultiValue().quotientRule( 2+i, 2+i );
 }
 
-double Steinhardt::deriv_poly( const unsigned& m, const double& val, double& df ) const {
-  double fact=1.0;
-  for(unsigned j=1; j<=m; ++j) fact=fact*j;
-  double res=coeff_poly[m]*fact;
-
-  double pow=1.0, xi=val, dxi=1.0; df=0.0;
-  for(int i=m+1; i<=tmom; ++i) {
-    double fact=1.0;
-    for(unsigned j=i-m+1; j<=i; ++j) fact=fact*j;
-    res=res+coeff_poly[i]*fact*xi;
-    df = df + pow*coeff_poly[i]*fact*dxi;
-    xi=xi*val; dxi=dxi*val; pow+=1.0;
-  }
-  df = df*normaliz[m];
-  return normaliz[m]*res;
-}
-
 }
 }
@@ -22,7 +22,6 @@
 #ifndef __PLUMED_crystallization_Steinhardt_h
 #define __PLUMED_crystallization_Steinhardt_h
 
-#include <complex>
 #include "tools/SwitchingFunction.h"
 #include "VectorMultiColvar.h"
 
@@ -31,18 +30,25 @@ namespace crystallization {
 
 class Steinhardt : public VectorMultiColvar {
 private:
+/// Neighbours are processed in blocks of this size
+  static const unsigned neighBlockSize=64;
   unsigned tmom;
   double rcut,rcut2;
   SwitchingFunction switchingFunction;
+/// The coefficients of the polynomials in z/r that multiply ((x+iy)/r)^m in the spherical harmonics
+/// with angular momentum tmom.  poly_coeff[m][j] multiplies (z/r)^j and includes the normalization.
+  std::vector<std::vector<double> > poly_coeff;
+/// The coefficients for the derivatives of these polynomials with respect to z/r
+  std::vector<std::vector<double> > dpoly_coeff;
+/// Evaluate the polynomial for m and its derivative with respect to z/r for n values of z/r
+  void evaluatePolynomials( const unsigned& m, const unsigned& n, const double* z, double* poly, double* dpoly ) const ;
 protected:
-  std::vector<double> coeff_poly;
-  std::vector<double> normaliz;
+/// Set the angular momentum and build the tables of spherical harmonics coefficients
   void setAngularMomentum( const unsigned& ang );
 public:
   static void registerKeywords( Keywords& keys );
   explicit Steinhardt( const ActionOptions& ao );
   void calculateVector( multicolvar::AtomValuePack& myatoms ) const ;
-  double deriv_poly( const unsigned&, const double&, double& ) const ;
 };
 
 }
@@ -81,13 +81,10 @@ void Function::apply()
   #pragma omp parallel num_threads(OpenMP::getNumThreads()) shared(f)
   {
     vector<double> omp_f(noa,0.0);
-    vector<double> forces(noa);
+// components with sparse derivatives only add forces on the arguments they depend on
     #pragma omp for reduction( + : at_least_one_forced)
     for(unsigned i=rank; i<ncp; i+=stride) {
-      if(getPntrToComponent(i)->applyForce(forces)) {
-        at_least_one_forced+=1;
-        for(unsigned j=0; j<noa; j++) omp_f[j]+=forces[j];
-      }
+      if(getPntrToComponent(i)->accumulateForces(omp_f)) at_least_one_forced+=1;
     }
     #pragma omp critical
     for(unsigned j=0; j<noa; j++) f[j]+=omp_f[j];
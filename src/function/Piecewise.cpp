@@ -115,6 +115,8 @@ Piecewise::Piecewise(const ActionOptions&ao):
     addValueWithDerivatives();
     setNotPeriodic();
   } else {
+// each component depends on one argument only
+    useSparseDerivatives();
     for(unsigned i=0; i<getNumberOfArguments(); i++) {
       addComponentWithDerivatives( getPntrToArgument(i)->getName()+"_pfunc" );
       getPntrToComponent(i)->setNotPeriodic();
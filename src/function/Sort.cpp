@@ -79,6 +79,8 @@ Sort::Sort(const ActionOptions&ao):
   Action(ao),
   Function(ao)
 {
+// each component depends on one argument only
+  useSparseDerivatives();
   for(unsigned i=0; i<getNumberOfArguments(); ++i) {
     string s;
     Tools::convert(i+1,s);
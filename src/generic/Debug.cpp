@@ -23,6 +23,7 @@
 #include "core/ActionPilot.h"
 #include "core/ActionSet.h"
 #include "core/PlumedMain.h"
+#include "tools/Communicator.h"
 
 using namespace std;
 
@@ -44,6 +45,18 @@ DEBUG DETAILED_TIMERS
 DEBUG logRequestedAtoms STRIDE=2
 \endplumedfile
 
+When PARALLEL_ACTIONS is used actions that do not depend on each other are calculated and apply their
+forces at the same time using the threads set with PLUMED_NUM_THREADS.  This is only done when
+MPI is not initialized (e.g. with plumed --no-mpi driver), since actions may communicate while they
+are calculated.  Detailed timers are not collected
+for the actions that are run concurrently.
+\plumedfile
+# the two torsions are calculated at the same time
+DEBUG PARALLEL_ACTIONS
+phi: TORSION ATOMS=5,7,9,15
+psi: TORSION ATOMS=7,9,15,17
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 class Debug:
@@ -72,6 +85,7 @@ void Debug::registerKeywords( Keywords& keys ) {
   keys.addFlag("logRequestedAtoms",false,"write in the log which atoms have been requested at a given time");
   keys.addFlag("NOVIRIAL",false,"switch off the virial contribution for the entirity of the simulation");
   keys.addFlag("DETAILED_TIMERS",false,"switch on detailed timers");
+  keys.addFlag("PARALLEL_ACTIONS",false,"calculate and apply the actions that do not depend on each other at the same time using multiple threads");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
 }
 
@@ -91,6 +105,11 @@ Debug::Debug(const ActionOptions&ao):
   parseFlag("DETAILED_TIMERS",detailedTimers);
   if(detailedTimers) log.printf("  Detailed timing on\n");
   plumed.detailedTimers=true;
+  bool parallelActions=false;
+  parseFlag("PARALLEL_ACTIONS",parallelActions);
+  if(parallelActions) log.printf("  Running independent actions concurrently\n");
+  if(parallelActions && Communicator::initialized()) log.printf("  MPI is initialized, so actions will be run one after the other\n");
+  if(parallelActions) plumed.parallelActions=true;
   ofile.link(*this);
   std::string file;
   parse("FILE",file);
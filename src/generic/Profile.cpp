@@ -0,0 +1,138 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2017 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "core/ActionRegister.h"
+#include "core/ActionPilot.h"
+#include "core/PlumedMain.h"
+#include "tools/Profiler.h"
+#include "tools/Communicator.h"
+#include "tools/File.h"
+
+namespace PLMD {
+namespace generic {
+
+using namespace std;
+
+//+PLUMEDOC GENERIC PROFILE
+/*
+Periodically write timings and counters to a file.
+
+When this action is present, PLUMED measures the time spent in each phase of the calculation
+(the same phases reported in the log at the end of the run) and in the calculate() and apply()
+methods of each action. In addition, a few counters are incremented, namely:
+- the number of tasks run by each action based on tasks (e.g. multicolvars), as `label tasks`;
+- the number of neighbor list updates of \ref COORDINATION and related variables, as `label neighbor list updates`;
+- the number of bytes reduced with MPI by this process, as `MPI bytes summed`.
+
+Every STRIDE steps the values accumulated since the previous write are written on FILE,
+together with the values accumulated since the beginning of the run.
+This makes it possible to follow where time is spent in a long simulation
+without waiting for it to finish.
+
+With FORMAT=csv each write adds one line per timer or counter with the columns
+`step,type,name,calls,window,max,total`, where times are in seconds and `max` is the
+longest single call in the window.
+With FORMAT=json each write adds a single line containing a JSON object.
+
+Each MPI process and each replica writes its own numbers. Only the master process of each replica writes
+on the file.
+
+\par Examples
+
+The following input writes timings every 1000 steps on a file named profile.csv
+\plumedfile
+PROFILE FILE=profile.csv STRIDE=1000
+\endplumedfile
+
+The same in JSON format
+\plumedfile
+PROFILE FILE=profile.json STRIDE=1000 FORMAT=json
+\endplumedfile
+
+*/
+//+ENDPLUMEDOC
+
+class Profile:
+  public ActionPilot
+{
+  OFile ofile;
+  Profiler profiler;
+  bool json;
+/// Bytes reduced in MPI at the previous write
+  unsigned long long bytesSummed;
+public:
+  explicit Profile(const ActionOptions&ao);
+  ~Profile();
+  static void registerKeywords( Keywords& keys );
+  void calculate() {}
+  void apply() {}
+  void update();
+};
+
+PLUMED_REGISTER_ACTION(Profile,"PROFILE")
+
+void Profile::registerKeywords( Keywords& keys ) {
+  Action::registerKeywords( keys );
+  ActionPilot::registerKeywords( keys );
+  keys.add("compulsory","STRIDE","1000","the frequency with which timings and counters should be written");
+  keys.add("compulsory","FILE","the name of the file on which to output timings and counters");
+  keys.add("compulsory","FORMAT","csv","the format of the file, either csv or json");
+  keys.remove("LABEL");
+}
+
+Profile::Profile(const ActionOptions&ao):
+  Action(ao),
+  ActionPilot(ao),
+  json(false),
+  bytesSummed(plumed.comm.getBytesSummed())
+{
+  if(plumed.profiler) error("PROFILE can be used only once");
+  std::string file;
+  parse("FILE",file);
+  if(file.length()==0) error("name of output file was not specified");
+  std::string format;
+  parse("FORMAT",format);
+  if(format=="json") json=true;
+  else if(format!="csv") error("FORMAT should be either csv or json");
+  checkRead();
+
+  ofile.link(*this);
+  ofile.open(file);
+  log.printf("  writing timings and counters every %d steps on file %s in %s format\n",getStride(),file.c_str(),format.c_str());
+  plumed.profiler=&profiler;
+}
+
+Profile::~Profile() {
+  plumed.profiler=NULL;
+}
+
+void Profile::update() {
+  unsigned long long bytes=plumed.comm.getBytesSummed();
+  profiler.count("MPI bytes summed",bytes-bytesSummed);
+  bytesSummed=bytes;
+  if(json) profiler.writeJSON(ofile,getStep());
+  else profiler.writeCSV(ofile,getStep());
+  ofile.flush();
+  profiler.resetWindow();
+}
+
+}
+}
@@ -92,14 +92,11 @@ KernelFunctions* HistogramOnGrid::getKernelAndNeighbors( std::vector<double>& po
   return NULL;
 }
 
-std::vector<Value*> HistogramOnGrid::getVectorOfValues() const {
-  std::vector<Value*> vv;
+void HistogramOnGrid::getKernelDisplacement( const std::vector<double>& x, const std::vector<double>& center, double* dp ) const {
   for(unsigned i=0; i<dimension; ++i) {
-    vv.push_back(new Value());
-    if( pbc[i] ) vv[i]->setDomain( str_min[i], str_max[i] );
-    else vv[i]->setNotPeriodic();
+    dp[i]=x[i]-center[i];
+    if( pbc[i] ) { double period=getGridExtent(i); dp[i]=Tools::pbc( dp[i]/period )*period; }
   }
-  return vv;
 }
 
 void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
@@ -124,28 +121,34 @@ void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, st
     } else {
       double totwforce=0.0;
       std::vector<double> intforce( 2*dimension, 0.0 );
-      std::vector<Value*> vv( getVectorOfValues() );
 
-      double newval; std::vector<unsigned> tindices( dimension ); std::vector<double> xx( dimension );
-      for(unsigned i=0; i<num_neigh; ++i) {
-        unsigned ineigh=neighbors[i];
-        if( inactive( ineigh ) ) continue ;
-        getGridPointCoordinates( ineigh, tindices, xx );
+      // Displacements of the active grid points from the kernel center, so that the kernel is evaluated on all of them at once
+      std::vector<unsigned> active; active.reserve( num_neigh );
+      for(unsigned i=0; i<num_neigh; ++i) if( !inactive( neighbors[i] ) ) active.push_back( neighbors[i] );
+      unsigned nact=active.size();
+      std::vector<double> dp( dimension*nact ), vals( nact ), ders( dimension*nact );
+      std::vector<unsigned> tindices( dimension ); std::vector<double> xx( dimension );
+      for(unsigned i=0; i<nact; ++i) {
+        getGridPointCoordinates( active[i], tindices, xx );
         if( kernel ) {
-          for(unsigned j=0; j<dimension; ++j) vv[j]->set(xx[j]);
-          newval = kernel->evaluate( vv, der, true );
+          getKernelDisplacement( xx, point, &dp[dimension*i] );
         } else {
           // Evalulate dot product
-          double dot=0; for(unsigned j=0; j<dimension; ++j) { dot+=xx[j]*point[j]; der[j]=xx[j]; }
+          double dot=0; for(unsigned j=0; j<dimension; ++j) { dot+=xx[j]*point[j]; ders[dimension*i+j]=xx[j]; }
           // Von misses distribution for concentration parameter
-          newval = von_misses_norm*exp( von_misses_concentration*dot );
+          vals[i] = von_misses_norm*exp( von_misses_concentration*dot );
           // And final derivatives
-          for(unsigned j=0; j<dimension; ++j) der[j] *= von_misses_concentration*newval;
+          for(unsigned j=0; j<dimension; ++j) ders[dimension*i+j] *= von_misses_concentration*vals[i];
         }
-        accumulate( ineigh, weight, newval, der, buffer );
+      }
+      if( kernel && nact>0 ) kernel->evaluate( nact, &dp[0], &vals[0], &ders[0] );
+
+      for(unsigned i=0; i<nact; ++i) {
+        for(unsigned j=0; j<dimension; ++j) der[j]=ders[dimension*i+j];
+        accumulate( active[i], weight, vals[i], der, buffer );
         if( wasForced() ) {
-          accumulateForce( ineigh, weight, der, intforce );
-          totwforce += myvals.get( 1+dimension )*newval*forces[ineigh];
+          accumulateForce( active[i], weight, der, intforce );
+          totwforce += myvals.get( 1+dimension )*vals[i]*forces[active[i]];
         }
       }
       if( wasForced() ) {
@@ -170,7 +173,6 @@ void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, st
         }
       }
       if( kernel ) delete kernel;
-      for(unsigned i=0; i<dimension; ++i) delete vv[i];
     }
   }
 }
@@ -52,7 +52,8 @@ public:
   virtual void accumulateForce( const unsigned& ipoint, const double& weight, const std::vector<double>& der, std::vector<double>& intforce ) const ;
   unsigned getNumberOfBufferPoints() const ;
   KernelFunctions* getKernelAndNeighbors( std::vector<double>& point, unsigned& num_neigh, std::vector<unsigned>& neighbors ) const;
-  std::vector<Value*> getVectorOfValues() const ;
+/// Get the displacement of a point from the center of a kernel, taking periodicity into account
+  void getKernelDisplacement( const std::vector<double>& x, const std::vector<double>& center, double* dp ) const ;
   void addOneKernelEachTimeOnly() { addOneKernelAtATime=true; }
   virtual void getFinalForces( const std::vector<double>& buffer, std::vector<double>& finalForces );
   bool noDiscreteKernels() const ;
@@ -82,9 +82,13 @@ PRINT ARG=cn0.mean,cn1.mean,cn2.mean STRIDE=1 FILE=cn_out
 
 class CoordinationNumbers : public MultiColvarBase {
 private:
+/// Number of neighbors passed at once to the switching function
+  static const unsigned blockSize=64;
   double rcut2;
   int r_power;
   SwitchingFunction switchingFunction;
+/// Add the contributions of a block of n neighbors with squared distances d2
+  void accumulateBlock( const unsigned& n, const unsigned* ind, const double* d2, AtomValuePack& myatoms ) const ;
 public:
   static void registerKeywords( Keywords& keys );
   explicit CoordinationNumbers(const ActionOptions&);
@@ -157,29 +161,39 @@ CoordinationNumbers::CoordinationNumbers(const ActionOptions&ao):
 
 double CoordinationNumbers::compute( const unsigned& tindex, AtomValuePack& myatoms ) const {
   // Calculate the coordination number
-  double dfunc, d2, sw, d, raised;
+  // Neighbors within the cutoff are collected in blocks and the switching function is computed on a whole block
+  unsigned ind[blockSize], n=0; double d2[blockSize];
   for(unsigned i=1; i<myatoms.getNumberOfAtoms(); ++i) {
     Vector& distance=myatoms.getPosition(i);
-    if ( (d2=distance[0]*distance[0])<rcut2 &&
-         (d2+=distance[1]*distance[1])<rcut2 &&
-         (d2+=distance[2]*distance[2])<rcut2 &&
-         d2>epsilon ) {
-
-      sw = switchingFunction.calculateSqr( d2, dfunc );
-      if(r_power > 0) {
-        d = sqrt(d2); raised = pow( d, r_power - 1 );
-        accumulateSymmetryFunction( 1, i, sw * raised * d,
-                                    (dfunc * d * raised + sw * r_power) * distance,
-                                    (-dfunc * d * raised - sw * r_power) * Tensor(distance, distance),
-                                    myatoms );
-      } else {
-        accumulateSymmetryFunction( 1, i, sw, (dfunc)*distance, (-dfunc)*Tensor(distance,distance), myatoms );
-      }
+    if ( (d2[n]=distance[0]*distance[0])<rcut2 &&
+         (d2[n]+=distance[1]*distance[1])<rcut2 &&
+         (d2[n]+=distance[2]*distance[2])<rcut2 &&
+         d2[n]>epsilon ) {
+      ind[n]=i; n++;
+      if( n==blockSize ) { accumulateBlock( n, ind, d2, myatoms ); n=0; }
     }
   }
+  if( n>0 ) accumulateBlock( n, ind, d2, myatoms );
 
   return myatoms.getValue(1);
 }
 
+void CoordinationNumbers::accumulateBlock( const unsigned& n, const unsigned* ind, const double* d2, AtomValuePack& myatoms ) const {
+  double sw[blockSize], dfunc[blockSize], d, raised;
+  switchingFunction.calculateSqr( n, d2, sw, dfunc );
+  for(unsigned k=0; k<n; ++k) {
+    Vector& distance=myatoms.getPosition(ind[k]);
+    if(r_power > 0) {
+      d = sqrt(d2[k]); raised = pow( d, r_power - 1 );
+      accumulateSymmetryFunction( 1, ind[k], sw[k] * raised * d,
+                                  (dfunc[k] * d * raised + sw[k] * r_power) * distance,
+                                  (-dfunc[k] * d * raised - sw[k] * r_power) * Tensor(distance, distance),
+                                  myatoms );
+    } else {
+      accumulateSymmetryFunction( 1, ind[k], sw[k], (dfunc[k])*distance, (-dfunc[k])*Tensor(distance,distance), myatoms );
+    }
+  }
+}
+
 }
 }
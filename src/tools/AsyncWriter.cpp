@@ -0,0 +1,102 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "AsyncWriter.h"
+#include "OFile.h"
+#include "Exception.h"
+#include <algorithm>
+#include <cstring>
+
+namespace PLMD {
+
+AsyncWriter::AsyncWriter(std::size_t size):
+  buffer(size),
+  head(0),
+  tail(0),
+  used(0),
+  stopping(false)
+{
+  plumed_massert(size>0,"the buffer of the asynchronous writer should not be empty");
+  thread=std::thread(&AsyncWriter::run,this);
+}
+
+AsyncWriter::~AsyncWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping=true;
+  }
+  added.notify_all();
+  thread.join();
+}
+
+void AsyncWriter::write(OFile& f,const char*ptr,std::size_t s) {
+  const std::size_t capacity=buffer.size();
+  while(s>0) {
+// records longer than the buffer are split in pieces
+    const std::size_t n=std::min(s,capacity);
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      written.wait(lock,[&] {return capacity-used>=n;});
+      const std::size_t first=std::min(n,capacity-head);
+      std::memcpy(&buffer[head],ptr,first);
+      if(first<n) std::memcpy(&buffer[0],ptr+first,n-first);
+      head=(head+n)%capacity;
+      used+=n;
+      records.push_back(Record(&f,n));
+      f.asyncPending++;
+    }
+    added.notify_one();
+    ptr+=n; s-=n;
+  }
+}
+
+void AsyncWriter::wait(OFile& f) {
+  std::unique_lock<std::mutex> lock(mtx);
+  written.wait(lock,[&] {return f.asyncPending==0;});
+}
+
+void AsyncWriter::run() {
+  const std::size_t capacity=buffer.size();
+  while(true) {
+    Record r(NULL,0); std::size_t start;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      added.wait(lock,[&] {return stopping || !records.empty();});
+      if(records.empty()) return;
+      r=records.front(); start=tail;
+    }
+// the buffer is not modified where the record is stored until the space is released,
+// so that it can be written without holding the lock
+    const std::size_t first=std::min(r.size,capacity-start);
+    r.file->rawWrite(&buffer[start],first);
+    if(first<r.size) r.file->rawWrite(&buffer[0],r.size-first);
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      records.pop_front();
+      tail=(tail+r.size)%capacity;
+      used-=r.size;
+      r.file->asyncPending--;
+    }
+    written.notify_all();
+  }
+}
+
+}
@@ -0,0 +1,92 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2018 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_AsyncWriter_h
+#define __PLUMED_tools_AsyncWriter_h
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace PLMD {
+
+class OFile;
+
+/**
+\ingroup TOOLBOX
+Class writing the output of many files in a background thread.
+
+Every time a line is written on a file (see OFile::printf) its content is copied in a
+circular buffer and the actual write on disk (possibly compressed with zlib)
+is done by a separate thread. When the buffer is full the thread writing the lines waits until some
+space is freed, so that the memory used is bounded.  Lines written on the same file
+are written in order.  wait() returns when all the lines written on a file have reached the file, so
+that OFile::flush() and OFile::close() behave as if the file was written directly.
+\verbatim
+AsyncWriter writer(1024*1024);
+OFile of;
+of.open("COLVAR");
+of.setAsyncWriter(&writer);
+of.printf("%d\n",1);
+of.flush(); // here the line is in the file
+\endverbatim
+*/
+class AsyncWriter {
+/// A piece of output of a file that is stored in the buffer
+  class Record {
+  public:
+    OFile* file;
+    std::size_t size;
+    Record(OFile* f,std::size_t s): file(f), size(s) {}
+  };
+/// The circular buffer with the content of the records
+  std::vector<char> buffer;
+/// Position where the next record is stored and where the first record starts
+  std::size_t head, tail;
+/// Number of bytes in the buffer
+  std::size_t used;
+/// Records in the buffer, in the order they were added
+  std::deque<Record> records;
+/// Set when the thread should stop
+  bool stopping;
+  std::mutex mtx;
+/// Signalled when a record is added, when one is written and when there is space in the buffer
+  std::condition_variable added, written;
+  std::thread thread;
+/// The loop run by the background thread
+  void run();
+public:
+/// Start the background thread, size is the size of the buffer in bytes.
+/// Throws std::system_error if the thread cannot be started
+  explicit AsyncWriter(std::size_t size);
+/// Write everything that is left and stop the background thread
+  ~AsyncWriter();
+/// Queue some output of file f, waiting if the buffer is full
+  void write(OFile& f,const char*ptr,std::size_t s);
+/// Wait until all the output of file f has been written
+  void wait(OFile& f);
+};
+
+}
+
+#endif
@@ -27,10 +27,11 @@ using namespace std;
 
 namespace PLMD {
 
-Communicator::Communicator()
+Communicator::Communicator():
 #ifdef __PLUMED_HAS_MPI
-  : communicator(MPI_COMM_SELF)
+  communicator(MPI_COMM_SELF),
 #endif
+  bytesSummed(0)
 {
 }
 
@@ -38,7 +39,9 @@ Communicator::Communicator()
 // Member variable 'Communicator::communicator' is not initialized in the constructor
 // this is a false positive so I suppress it
 // cppcheck-suppress uninitMemberVar
-Communicator::Communicator(const Communicator&pc) {
+Communicator::Communicator(const Communicator&pc):
+  bytesSummed(0)
+{
   Set_comm(pc.communicator);
 }
 
@@ -146,7 +149,22 @@ void Communicator::Bcast(Data data,int root) {
 // cppcheck-suppress passedByValue
 void Communicator::Sum(Data data) {
 #if defined(__PLUMED_HAS_MPI)
-  if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_SUM,communicator);
+  if(initialized()) {
+    int typesize;
+    MPI_Type_size(data.type,&typesize);
+    bytesSummed+=static_cast<unsigned long long>(typesize)*data.size;
+    MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_SUM,communicator);
+  }
+#else
+  (void) data;
+#endif
+}
+
+// data should be passed by value to allow conversions
+// cppcheck-suppress passedByValue
+void Communicator::Max(Data data) {
+#if defined(__PLUMED_HAS_MPI)
+  if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_MAX,communicator);
 #else
   (void) data;
 #endif
@@ -205,6 +223,65 @@ void Communicator::Allgather(ConstData in,Data out) {
 #endif
 }
 
+// data should be passed by value to allow conversions
+// cppcheck-suppress passedByValue
+void Communicator::Gatherv(ConstData in,Data out,const int*recvcounts,const int*displs,int root) {
+#if defined(__PLUMED_HAS_MPI)
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+  void*s=const_cast<void*>((const void*)in.pointer);
+  void*r=const_cast<void*>((const void*)out.pointer);
+  int*rc=const_cast<int*>(recvcounts);
+  int*di=const_cast<int*>(displs);
+  if(s==NULL)s=MPI_IN_PLACE;
+  MPI_Gatherv(s,in.size,in.type,r,rc,di,out.type,root,communicator);
+#else
+  (void) in;
+  (void) out;
+  (void) recvcounts;
+  (void) displs;
+  (void) root;
+  plumed_merror("you are trying to use an MPI function, but PLUMED has been compiled without MPI support");
+#endif
+}
+
+// data should be passed by value to allow conversions
+// cppcheck-suppress passedByValue
+void Communicator::Alltoall(ConstData in,Data out) {
+#if defined(__PLUMED_HAS_MPI)
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+  void*s=const_cast<void*>((const void*)in.pointer);
+  void*r=const_cast<void*>((const void*)out.pointer);
+  MPI_Alltoall(s,in.size/Get_size(),in.type,r,out.size/Get_size(),out.type,communicator);
+#else
+  (void) in;
+  (void) out;
+  plumed_merror("you are trying to use an MPI function, but PLUMED has been compiled without MPI support");
+#endif
+}
+
+// data should be passed by value to allow conversions
+// cppcheck-suppress passedByValue
+void Communicator::Alltoallv(ConstData in,const int*sendcounts,const int*sdispls,Data out,const int*recvcounts,const int*rdispls) {
+#if defined(__PLUMED_HAS_MPI)
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+  void*s=const_cast<void*>((const void*)in.pointer);
+  void*r=const_cast<void*>((const void*)out.pointer);
+  int*sc=const_cast<int*>(sendcounts);
+  int*sd=const_cast<int*>(sdispls);
+  int*rc=const_cast<int*>(recvcounts);
+  int*rd=const_cast<int*>(rdispls);
+  MPI_Alltoallv(s,sc,sd,in.type,r,rc,rd,out.type,communicator);
+#else
+  (void) in;
+  (void) sendcounts;
+  (void) sdispls;
+  (void) out;
+  (void) recvcounts;
+  (void) rdispls;
+  plumed_merror("you are trying to use an MPI function, but PLUMED has been compiled without MPI support");
+#endif
+}
+
 // data should be passed by value to allow conversions
 // cppcheck-suppress passedByValue
 void Communicator::Recv(Data data,int source,int tag,Status&status) {
@@ -244,6 +321,14 @@ bool Communicator::initialized() {
   else return false;
 }
 
+bool Communicator::hasSharedMemory() {
+#if defined(__PLUMED_HAS_MPI) && MPI_VERSION>=3
+  return true;
+#else
+  return false;
+#endif
+}
+
 void Communicator::Request::wait(Status&s) {
 #ifdef __PLUMED_HAS_MPI
   plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
@@ -283,6 +368,59 @@ void Communicator::Split(int color,int key,Communicator&pc)const {
 #endif
 }
 
+void Communicator::Split_shared(Communicator&pc)const {
+#if defined(__PLUMED_HAS_MPI) && MPI_VERSION>=3
+  MPI_Comm_split_type(communicator,MPI_COMM_TYPE_SHARED,Get_rank(),MPI_INFO_NULL,&pc.communicator);
+#else
+  (void) pc;
+  plumed_merror("you are trying to use an MPI-3 function, but PLUMED has been compiled without MPI-3 support");
+#endif
+}
+
+Communicator::SharedWindow::~SharedWindow() {
+  free();
+}
+
+void Communicator::SharedWindow::allocate(Communicator&comm,size_t b) {
+#if defined(__PLUMED_HAS_MPI) && MPI_VERSION>=3
+  plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
+  free();
+// only the first process owns the memory, the others just map it
+  MPI_Aint mysize=(comm.Get_rank()==0 ? b : 0);
+  MPI_Win_allocate_shared(mysize,1,MPI_INFO_NULL,comm.communicator,&pointer,&win);
+  MPI_Aint qsize;
+  int disp;
+  MPI_Win_shared_query(win,0,&qsize,&disp,&pointer);
+// passive target epoch lasting for the whole life of the window
+  MPI_Win_lock_all(MPI_MODE_NOCHECK,win);
+  bytes=b;
+#else
+  (void) comm;
+  (void) b;
+  plumed_merror("you are trying to use an MPI-3 function, but PLUMED has been compiled without MPI-3 support");
+#endif
+}
+
+void Communicator::SharedWindow::free() {
+  if(!pointer) return;
+#if defined(__PLUMED_HAS_MPI) && MPI_VERSION>=3
+  int finalized=0;
+  MPI_Finalized(&finalized);
+  if(initialized() && !finalized) {
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+  }
+#endif
+  pointer=NULL;
+  bytes=0;
+}
+
+void Communicator::SharedWindow::sync() {
+#if defined(__PLUMED_HAS_MPI) && MPI_VERSION>=3
+  MPI_Win_sync(win);
+#endif
+}
+
 int Communicator::Status::Get_count(MPI_Datatype type)const {
   int i;
 #ifdef __PLUMED_HAS_MPI
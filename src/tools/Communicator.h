@@ -43,6 +43,8 @@ class MPI_Datatype {};
 class MPI_Status {};
 /// Surrogate of MPI_Request when MPI library is not available
 class MPI_Request {};
+/// Surrogate of MPI_Win when MPI library is not available
+class MPI_Win {};
 #endif
 
 /// \ingroup TOOLBOX
@@ -51,6 +53,8 @@ class MPI_Request {};
 class Communicator {
 /// Communicator
   MPI_Comm communicator;
+/// Number of bytes reduced with Sum() so far
+  unsigned long long bytesSummed;
 /// Function returning the MPI type.
 /// You can use it to access to the MPI type of a C++ type, e.g.
 /// `MPI_Datatype type=getMPIType<double>();`
@@ -139,6 +143,32 @@ public:
     MPI_Request r;
     void wait(Status&s=StatusIgnore);
   };
+/// Wrapper class for an MPI-3 shared memory window.
+/// Memory is allocated by the first process of the communicator and can be
+/// directly accessed by all the other processes, that should thus belong to the same node
+/// (see Split_shared()). Accesses should be separated with sync() and Barrier().
+  class SharedWindow {
+    MPI_Win win;
+    void* pointer;
+    size_t bytes;
+    SharedWindow(const SharedWindow&);
+    SharedWindow& operator=(const SharedWindow&);
+  public:
+    SharedWindow(): pointer(NULL), bytes(0) {}
+    ~SharedWindow();
+/// Allocate (collectively) a window of the given number of bytes.
+/// A previously allocated window is released
+    void allocate(Communicator&,size_t bytes);
+/// Release the window
+    void free();
+/// Size of the window in bytes
+    size_t size()const {return bytes;}
+/// Pointer to the beginning of the shared buffer
+    void* get()const {return pointer;}
+/// Wrapper to MPI_Win_sync, to be used before and after a Barrier()
+/// to make writes by other processes visible
+    void sync();
+  };
 /// Default constructor
   Communicator();
 /// Copy constructor.
@@ -171,10 +201,14 @@ public:
   void Barrier()const;
 /// Tests if MPI library is initialized
   static bool initialized();
+/// Tests if MPI-3 shared memory windows are available
+  static bool hasSharedMemory();
 
 /// Returns MPI_COMM_WORLD if MPI is initialized, otherwise the default communicator
   static Communicator & Get_world();
 
+/// Get the number of bytes reduced with Sum() by this process since the communicator was created
+  unsigned long long getBytesSummed()const {return bytesSummed;}
 /// Wrapper for MPI_Allreduce with MPI_SUM (data struct)
   void Sum(Data);
 /// Wrapper for MPI_Allreduce with MPI_SUM (pointer)
@@ -182,6 +216,13 @@ public:
 /// Wrapper for MPI_Allreduce with MPI_SUM (reference)
   template <class T> void Sum(T&buf) {Sum(Data(buf));}
 
+/// Wrapper for MPI_Allreduce with MPI_MAX (data struct)
+  void Max(Data);
+/// Wrapper for MPI_Allreduce with MPI_MAX (pointer)
+  template <class T> void Max(T*buf,int count) {Max(Data(buf,count));}
+/// Wrapper for MPI_Allreduce with MPI_MAX (reference)
+  template <class T> void Max(T&buf) {Max(Data(buf));}
+
 /// Wrapper for MPI_Bcast (data struct)
   void Bcast(Data,int);
 /// Wrapper for MPI_Bcast (pointer)
@@ -207,6 +248,13 @@ public:
     Allgatherv(ConstData(sendbuf),Data(recvbuf),recvcounts,displs);
   }
 
+/// Wrapper for MPI_Gatherv (data struct)
+  void Gatherv(ConstData in,Data out,const int*,const int*,int root);
+/// Wrapper for MPI_Gatherv (pointer)
+  template <class T,class S> void Gatherv(const T*sendbuf,int sendcount,S*recvbuf,const int*recvcounts,const int*displs,int root) {
+    Gatherv(ConstData(sendbuf,sendcount),Data(recvbuf,0),recvcounts,displs,root);
+  }
+
 /// Wrapper for MPI_Allgather (data struct)
   void Allgather(ConstData in,Data out);
 /// Wrapper for MPI_Allgatherv (pointer)
@@ -218,6 +266,20 @@ public:
     Allgather(ConstData(sendbuf),Data(recvbuf));
   }
 
+/// Wrapper for MPI_Alltoall (data struct)
+  void Alltoall(ConstData in,Data out);
+/// Wrapper for MPI_Alltoall (reference)
+  template <class T,class S> void Alltoall(const T&sendbuf,S&recvbuf) {
+    Alltoall(ConstData(sendbuf),Data(recvbuf));
+  }
+
+/// Wrapper for MPI_Alltoallv (data struct)
+  void Alltoallv(ConstData in,const int*,const int*,Data out,const int*,const int*);
+/// Wrapper for MPI_Alltoallv (pointer)
+  template <class T,class S> void Alltoallv(const T*sendbuf,const int*sendcounts,const int*sdispls,S*recvbuf,const int*recvcounts,const int*rdispls) {
+    Alltoallv(ConstData(sendbuf,0),sendcounts,sdispls,Data(recvbuf,0),recvcounts,rdispls);
+  }
+
 /// Wrapper for MPI_Recv (data struct)
   void Recv(Data,int,int,Status&s=StatusIgnore);
 /// Wrapper for MPI_Recv (pointer)
@@ -227,6 +289,9 @@ public:
 
 /// Wrapper to MPI_Comm_split
   void Split(int,int,Communicator&)const;
+/// Wrapper to MPI_Comm_split_type with MPI_COMM_TYPE_SHARED.
+/// It groups the processes that can share memory (i.e. that are on the same node)
+  void Split_shared(Communicator&)const;
 };
 
 }
@@ -35,6 +35,7 @@
 #include <sstream>
 #include <cstdio>
 #include <cfloat>
+#include <algorithm>
 
 using namespace std;
 namespace PLMD {
@@ -192,6 +193,12 @@ Grid::index_t Grid::getIndex(const vector<double> & x) const {
 // we are flattening arrays using a column-major order
 vector<unsigned> Grid::getIndices(index_t index) const {
   vector<unsigned> indices(dimension_);
+  getIndices(index,indices);
+  return indices;
+}
+
+void Grid::getIndices(index_t index,std::vector<unsigned> & indices) const {
+  plumed_dbg_assert(indices.size()==dimension_);
   index_t kk=index;
   indices[0]=(index%nbin_[0]);
   for(unsigned int i=1; i<dimension_-1; ++i) {
@@ -201,7 +208,6 @@ vector<unsigned> Grid::getIndices(index_t index) const {
   if(dimension_>=2) {
     indices[dimension_-1]=((kk-indices[dimension_-2])/nbin_[dimension_-2]);
   }
-  return indices;
 }
 
 vector<unsigned> Grid::getIndices(const vector<double> & x) const {
@@ -672,16 +678,23 @@ Grid* Grid::create(const std::string& funcl, const std::vector<Value*> & args, I
 
   vector<double> xx(nvar),dder(nvar);
   vector<double> dx=grid->getDx();
+// names of the fields, so that they are not built again for every point
+  std::vector<std::string> minNames(nvar),maxNames(nvar),nbinsNames(nvar),periodicNames(nvar),derNames(nvar);
+  for(unsigned i=0; i<nvar; ++i) {
+    minNames[i]="min_" + labels[i]; maxNames[i]="max_" + labels[i];
+    nbinsNames[i]="nbins_" + labels[i]; periodicNames[i]="periodic_" + labels[i];
+    derNames[i]="der_" + args[i]->getName();
+  }
   double f,x;
   while( ifile.scanField(funcl,f) ) {
     for(unsigned i=0; i<nvar; ++i) {
       ifile.scanField(labels[i],x); xx[i]=x+dx[i]/2.0;
-      ifile.scanField( "min_" + labels[i], gmin[i]);
-      ifile.scanField( "max_" + labels[i], gmax[i]);
-      ifile.scanField( "nbins_" + labels[i], gbin1[i]);
-      ifile.scanField( "periodic_" + labels[i], pstring );
+      ifile.scanField( minNames[i], gmin[i]);
+      ifile.scanField( maxNames[i], gmax[i]);
+      ifile.scanField( nbinsNames[i], gbin1[i]);
+      ifile.scanField( periodicNames[i], pstring );
     }
-    if(hasder) { for(unsigned i=0; i<nvar; ++i) { ifile.scanField( "der_" + args[i]->getName(), dder[i] ); } }
+    if(hasder) { for(unsigned i=0; i<nvar; ++i) { ifile.scanField( derNames[i], dder[i] ); } }
     index_t index=grid->getIndex(xx);
     if(doder) {grid->setValueAndDerivatives(index,f,dder);}
     else {grid->setValue(index,f);}
@@ -691,12 +704,122 @@ Grid* Grid::create(const std::string& funcl, const std::vector<Value*> & args, I
 }
 
 // Sparse version of grid with map
+SparseGrid::SparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                       const std::vector<std::string> & gmax,
+                       const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
+  Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false),
+  bedge_(dimension_),
+  nblock_(dimension_),
+  bsize_(1),
+  stride_(usederiv ? 1+dimension_ : 1),
+  nblocks_(0),
+  npoints_(0)
+{
+// blocks of 8^d points, with smaller edges in high dimension so that blocks do not exceed 4096 points
+  unsigned edge=8;
+  while(edge>1) {
+    double npb=1.0;
+    for(unsigned j=0; j<dimension_; ++j) npb*=edge;
+    if(npb<=4096) break;
+    edge/=2;
+  }
+  for(unsigned j=0; j<dimension_; ++j) {
+    bedge_[j]=(edge<nbin_[j] ? edge : nbin_[j]);
+    nblock_[j]=(nbin_[j]+bedge_[j]-1)/bedge_[j];
+    bsize_*=bedge_[j];
+  }
+  clear();
+}
+
 void SparseGrid::clear() {
-  map_.clear();
+  keys_.assign(64,static_cast<index_t>(-1));
+  slots_.assign(64,0);
+  nblocks_=0;
+  npoints_=0;
+  data_.clear();
+  touched_.clear();
+}
+
+void SparseGrid::locate(index_t index,index_t& block,unsigned& offset)const {
+  index_t kk=index;
+  index_t bstride=1;
+  unsigned ostride=1;
+  block=0;
+  offset=0;
+  for(unsigned j=0; j<dimension_; ++j) {
+    const unsigned i=kk%nbin_[j];
+    kk/=nbin_[j];
+    block+=bstride*(i/bedge_[j]);
+    offset+=ostride*(i%bedge_[j]);
+    bstride*=nblock_[j];
+    ostride*=bedge_[j];
+  }
+}
+
+Grid::index_t SparseGrid::getPointIndex(index_t block,unsigned offset)const {
+  index_t index=0;
+  index_t stride=1;
+  for(unsigned j=0; j<dimension_; ++j) {
+    const index_t i=(block%nblock_[j])*bedge_[j]+offset%bedge_[j];
+    block/=nblock_[j];
+    offset/=bedge_[j];
+    index+=stride*i;
+    stride*=nbin_[j];
+  }
+  return index;
+}
+
+size_t SparseGrid::findSlot(index_t block)const {
+  const size_t mask=keys_.size()-1;
+// Fibonacci hashing, then linear probing
+  size_t h=static_cast<size_t>((static_cast<unsigned long long>(block)*11400714819323198485ULL)>>20)&mask;
+  while(keys_[h]!=block && keys_[h]!=static_cast<index_t>(-1)) h=(h+1)&mask;
+  return h;
+}
+
+const double* SparseGrid::find(index_t index)const {
+  index_t block;
+  unsigned offset;
+  locate(index,block,offset);
+  const size_t h=findSlot(block);
+  if(keys_[h]!=block) return NULL;
+  return &data_[(static_cast<size_t>(slots_[h])*bsize_+offset)*stride_];
+}
+
+double* SparseGrid::findOrAllocate(index_t index) {
+  index_t block;
+  unsigned offset;
+  locate(index,block,offset);
+  size_t h=findSlot(block);
+  if(keys_[h]!=block) {
+// keep the load factor below 1/2
+    if(2*(nblocks_+1)>keys_.size()) {
+      std::vector<index_t> oldkeys(2*keys_.size(),static_cast<index_t>(-1));
+      std::vector<unsigned> oldslots(2*keys_.size(),0);
+      oldkeys.swap(keys_);
+      oldslots.swap(slots_);
+      for(size_t i=0; i<oldkeys.size(); ++i) if(oldkeys[i]!=static_cast<index_t>(-1)) {
+          const size_t k=findSlot(oldkeys[i]);
+          keys_[k]=oldkeys[i];
+          slots_[k]=oldslots[i];
+        }
+      h=findSlot(block);
+    }
+    keys_[h]=block;
+    slots_[h]=nblocks_++;
+    data_.resize(static_cast<size_t>(nblocks_)*bsize_*stride_,0.0);
+    touched_.resize(static_cast<size_t>(nblocks_)*bsize_,0);
+  }
+  const size_t p=static_cast<size_t>(slots_[h])*bsize_+offset;
+  if(!touched_[p]) {
+    touched_[p]=1;
+    npoints_++;
+  }
+  return &data_[p*stride_];
 }
 
 Grid::index_t SparseGrid::getSize() const {
-  return map_.size();
+  return npoints_;
 }
 
 Grid::index_t SparseGrid::getMaxSize() const {
@@ -752,47 +875,46 @@ void Grid::findSetOfPointsOnContour(const double& target, const std::vector<bool
 
 double SparseGrid::getValue(index_t index)const {
   plumed_assert(index<maxsize_);
-  double value=0.0;
-  const auto it=map_.find(index);
-  if(it!=map_.end()) value=it->second;
-  return value;
+  const double* p=find(index);
+  return (p ? p[0] : 0.0);
 }
 
 double SparseGrid::getValueAndDerivatives
 (index_t index, vector<double>& der)const {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  double value=0.0;
-  for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
-  const auto it=map_.find(index);
-  if(it!=map_.end()) value=it->second;
-  const auto itder=der_.find(index);
-  if(itder!=der_.end()) der=itder->second;
-  return value;
+  const double* p=find(index);
+  if(!p) {
+    for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+    return 0.0;
+  }
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=p[1+i];
+  return p[0];
 }
 
 void SparseGrid::setValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
-  map_[index]=value;
+  findOrAllocate(index)[0]=value;
 }
 
 void SparseGrid::setValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  map_[index]=value;
-  der_[index]=der;
+  double* p=findOrAllocate(index);
+  p[0]=value;
+  for(unsigned int i=0; i<dimension_; ++i) p[1+i]=der[i];
 }
 
 void SparseGrid::addValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
-  map_[index]+=value;
+  findOrAllocate(index)[0]+=value;
 }
 
 void SparseGrid::addValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  map_[index]+=value;
-  der_[index].resize(dimension_);
-  for(unsigned int i=0; i<dimension_; ++i) der_[index][i]+=der[i];
+  double* p=findOrAllocate(index);
+  p[0]+=value;
+  for(unsigned int i=0; i<dimension_; ++i) p[1+i]+=der[i];
 }
 
 void SparseGrid::writeToFile(OFile& ofile) {
@@ -801,8 +923,17 @@ void SparseGrid::writeToFile(OFile& ofile) {
   double f;
   writeHeader(ofile);
   ofile.fmtField(" "+fmt_);
-  for(const auto & it : map_) {
-    index_t i=it.first;
+// points are written in order of index
+  vector<index_t> points;
+  points.reserve(npoints_);
+  for(size_t h=0; h<keys_.size(); ++h) {
+    if(keys_[h]==static_cast<index_t>(-1)) continue;
+    for(unsigned k=0; k<bsize_; ++k) {
+      if(touched_[static_cast<size_t>(slots_[h])*bsize_+k]) points.push_back(getPointIndex(keys_[h],k));
+    }
+  }
+  std::sort(points.begin(),points.end());
+  for(const auto & i : points) {
     xx=getPoint(i);
     if(usederiv_) {f=getValueAndDerivatives(i,der);}
     else {f=getValue(i);}
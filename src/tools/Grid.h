@@ -137,6 +137,7 @@ public:
   std::vector<double> getPoint(const std::vector<unsigned> & indices) const;
   std::vector<double> getPoint(const std::vector<double> & x) const;
 /// faster versions relying on preallocated vectors
+  void getIndices(index_t index,std::vector<unsigned> & indices) const;
   void getPoint(index_t index,std::vector<double> & point) const;
   void getPoint(const std::vector<unsigned> & indices,std::vector<double> & point) const;
   void getPoint(const std::vector<double> & x,std::vector<double> & point) const;
@@ -225,9 +226,37 @@ public:
 
 class SparseGrid : public Grid
 {
-
-  std::map<index_t,double> map_;
-  std::map< index_t,std::vector<double> > der_;
+/// Points are stored in blocks of bedge_[0]*bedge_[1]*... points,
+/// allocated only when one of their points is set.
+/// Value and derivatives of each point are contiguous.
+  std::vector<unsigned> bedge_;
+/// number of blocks along each dimension
+  std::vector<index_t> nblock_;
+/// number of points in a block
+  unsigned bsize_;
+/// number of doubles per point (value and, if used, derivatives)
+  unsigned stride_;
+/// open addressing hash table (linear probing) from block index to block position in data_
+  std::vector<index_t> keys_;
+  std::vector<unsigned> slots_;
+/// number of allocated blocks
+  unsigned nblocks_;
+/// number of points that have been set
+  index_t npoints_;
+/// values and derivatives, block after block
+  std::vector<double> data_;
+/// set to 1 for points that have been set, block after block
+  std::vector<char> touched_;
+/// index of the block containing a point and position of the point inside the block
+  void locate(index_t index,index_t& block,unsigned& offset)const;
+/// index of a point given its block and position inside the block
+  index_t getPointIndex(index_t block,unsigned offset)const;
+/// position of the hash table where a block is or should be stored
+  size_t findSlot(index_t block)const;
+/// pointer to the data of a point, or NULL if its block is not allocated
+  const double* find(index_t index)const;
+/// pointer to the data of a point, allocating its block if needed
+  double* findOrAllocate(index_t index);
 
 protected:
   void clear();
@@ -235,8 +264,7 @@ protected:
 public:
   SparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
              const std::vector<std::string> & gmax,
-             const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
-    Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false) {}
+             const std::vector<unsigned> & nbin, bool dospline, bool usederiv);
 
   index_t getSize() const;
   index_t getMaxSize() const;
@@ -0,0 +1,147 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2017 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "HashedBins.h"
+#include "Exception.h"
+#include <cmath>
+#include <algorithm>
+
+namespace PLMD {
+
+HashedBins::HashedBins(const std::vector<double>& width):
+  dimension_(width.size()),
+  width_(width),
+  request_(width),
+  pbc_(width.size(),false),
+  min_(width.size(),0.0),
+  period_(width.size(),0.0),
+  nbin_(width.size(),0),
+  nboxes_(0),
+  bits_(0)
+{
+  plumed_massert(dimension_>0 && dimension_<=64,"dimension should be between 1 and 64");
+  bits_=64/dimension_;
+  for(unsigned i=0; i<dimension_; ++i) plumed_massert(width_[i]>0.0,"bins should have a positive width");
+}
+
+void HashedBins::setPeriodic(unsigned i,double min,double max) {
+  plumed_assert(i<dimension_ && max>min);
+  plumed_massert(nboxes_==0,"periodicity should be set before adding boxes");
+  pbc_[i]=true;
+  min_[i]=min;
+  period_[i]=max-min;
+  setWidth(i,request_[i]);
+}
+
+void HashedBins::setWidth(unsigned i,double width) {
+  request_[i]=width;
+  width_[i]=width;
+  if(pbc_[i]) {
+    nbin_[i]=static_cast<long>(std::floor(period_[i]/width));
+    if(nbin_[i]<1) nbin_[i]=1;
+    width_[i]=period_[i]/nbin_[i];
+  }
+}
+
+long HashedBins::getBin(unsigned i,double x) const {
+  long ibin=static_cast<long>(std::floor((x-min_[i])/width_[i]));
+  if(pbc_[i]) {
+    ibin%=nbin_[i];
+    if(ibin<0) ibin+=nbin_[i];
+  }
+  return ibin;
+}
+
+unsigned long long HashedBins::getKey(const std::vector<long>& bin) const {
+  const unsigned long long mask=(bits_<64 ? (1ULL<<bits_)-1 : ~0ULL);
+  unsigned long long key=0;
+  for(unsigned i=0; i<dimension_; ++i) key|=(static_cast<unsigned long long>(bin[i])&mask)<<(i*bits_);
+  return key;
+}
+
+unsigned HashedBins::add(const std::vector<double>& center,const std::vector<double>& halfwidth) {
+  plumed_dbg_assert(center.size()==dimension_ && halfwidth.size()==dimension_);
+  centers_.insert(centers_.end(),center.begin(),center.end());
+  halfwidths_.insert(halfwidths_.end(),halfwidth.begin(),halfwidth.end());
+  bool rebin=false;
+  for(unsigned i=0; i<dimension_; ++i) if(2.0*halfwidth[i]>request_[i]) {
+// bins are enlarged at least by 25%, so that boxes are not stored again too many times
+// when their width keeps growing
+      setWidth(i,std::max(2.0*halfwidth[i],1.25*request_[i]));
+      rebin=true;
+    }
+  if(rebin) {
+    bins_.clear();
+    for(unsigned ibox=0; ibox<nboxes_; ++ibox) store(ibox);
+  }
+  store(nboxes_);
+  return nboxes_++;
+}
+
+void HashedBins::store(unsigned ibox) {
+  const double* center=&centers_[ibox*dimension_];
+  const double* halfwidth=&halfwidths_[ibox*dimension_];
+// bins overlapped by the box along each dimension
+  std::vector<std::vector<long> > ranges(dimension_);
+  for(unsigned i=0; i<dimension_; ++i) {
+    if(pbc_[i] && 2.0*halfwidth[i]>=period_[i]-width_[i]) {
+      for(long ibin=0; ibin<nbin_[i]; ++ibin) ranges[i].push_back(ibin);
+    } else {
+      long first=static_cast<long>(std::floor((center[i]-halfwidth[i]-min_[i])/width_[i]));
+      long last=static_cast<long>(std::floor((center[i]+halfwidth[i]-min_[i])/width_[i]));
+      for(long ibin=first; ibin<=last; ++ibin) {
+        long jbin=ibin;
+        if(pbc_[i]) {
+          jbin%=nbin_[i];
+          if(jbin<0) jbin+=nbin_[i];
+        }
+        ranges[i].push_back(jbin);
+      }
+    }
+  }
+// loop over all the combinations
+  std::vector<unsigned> counter(dimension_,0);
+  std::vector<long> key(dimension_);
+  while(true) {
+    for(unsigned i=0; i<dimension_; ++i) key[i]=ranges[i][counter[i]];
+    std::vector<unsigned> & list(bins_[getKey(key)]);
+// different bins overlapped by this box might share the same key
+    if(list.empty() || list.back()!=ibox) list.push_back(ibox);
+    unsigned i=0;
+    for(; i<dimension_; ++i) {
+      counter[i]++;
+      if(counter[i]<ranges[i].size()) break;
+      counter[i]=0;
+    }
+    if(i==dimension_) break;
+  }
+}
+
+const std::vector<unsigned>& HashedBins::get(const std::vector<double>& x) const {
+  plumed_dbg_assert(x.size()==dimension_);
+  std::vector<long> key(dimension_);
+  for(unsigned i=0; i<dimension_; ++i) key[i]=getBin(i,x[i]);
+  std::unordered_map<unsigned long long,std::vector<unsigned> >::const_iterator it=bins_.find(getKey(key));
+  if(it==bins_.end()) return empty_;
+  return it->second;
+}
+
+}
@@ -0,0 +1,97 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2017 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_HashedBins_h
+#define __PLUMED_tools_HashedBins_h
+
+#include <vector>
+#include <unordered_map>
+
+namespace PLMD {
+
+/// \ingroup TOOLBOX
+/// A class for finding quickly which boxes, out of a large set, contain a point.
+/// Space is divided in bins that are only stored when they are not empty,
+/// so that it can be used also when the domain is not bounded.
+/// Each box is stored in all the bins that it overlaps, so that the
+/// boxes containing a point can be found by looking at a single bin.
+/// Bins are stored in a hash table with the bin indices along all the dimensions
+/// packed in a single integer. Since the domain is not bounded, bins that are far
+/// apart might share the same key: this only adds boxes to the list of candidates.
+/// When a box wider than the bins is added, the bins are enlarged and all the
+/// boxes are stored again, so that each box overlaps at most two bins per dimension.
+/// This is used to find the hills that contribute to the bias when
+/// metadynamics is used without a grid.
+class HashedBins {
+private:
+/// The dimension of the space
+  unsigned dimension_;
+/// The width of the bins along each dimension
+  std::vector<double> width_;
+/// The requested width of the bins, that is the largest box width seen so far
+  std::vector<double> request_;
+/// The periodicity of each dimension
+  std::vector<bool> pbc_;
+/// The lower boundary and the period of periodic dimensions
+  std::vector<double> min_, period_;
+/// The number of bins along periodic dimensions
+  std::vector<long> nbin_;
+/// The number of boxes stored
+  unsigned nboxes_;
+/// The centers and half widths of all the boxes, one box after the other
+  std::vector<double> centers_, halfwidths_;
+/// The number of bits of the key used for each dimension
+  unsigned bits_;
+/// The indices of the boxes overlapping each bin
+  std::unordered_map<unsigned long long,std::vector<unsigned> > bins_;
+/// An empty list, returned for empty bins
+  std::vector<unsigned> empty_;
+/// Set the width of the bins along dimension i, fitting the period if needed
+  void setWidth(unsigned i,double width);
+/// Store box ibox in all the bins that it overlaps
+  void store(unsigned ibox);
+/// Find the bin of coordinate x along dimension i
+  long getBin(unsigned i,double x) const;
+/// Pack the bin indices along each dimension in a single key
+  unsigned long long getKey(const std::vector<long>& bin) const;
+public:
+/// Create bins of given initial width. Dimensions are not periodic
+  explicit HashedBins(const std::vector<double>& width);
+/// Make dimension i periodic with the given domain.
+/// The width of the bins is decreased so as to fit the period
+  void setPeriodic(unsigned i,double min,double max);
+/// Add a box with given center and half width along each dimension, returns the index of the box
+  unsigned add(const std::vector<double>& center,const std::vector<double>& halfwidth);
+/// Get the indices of the boxes that might contain point x, sorted in increasing order.
+/// All the boxes that contain x are included.
+  const std::vector<unsigned>& get(const std::vector<double>& x) const;
+/// Get the number of boxes
+  unsigned size() const;
+};
+
+inline
+unsigned HashedBins::size() const {
+  return nboxes_;
+}
+
+}
+
+#endif
@@ -58,6 +58,27 @@ size_t IFile::llread(char*ptr,size_t s) {
   return r;
 }
 
+bool IFile::llgets(char*ptr,int n) {
+  plumed_assert(fp);
+  bool r;
+  if(gzfp) {
+#ifdef __PLUMED_HAS_ZLIB
+    r=gzgets(gzFile(gzfp),ptr,n);
+    if(!r) {
+      if(gzeof(gzFile(gzfp))) eof=true;
+      else err=true;
+    }
+#else
+    plumed_merror("trying to use a gz file without zlib being linked");
+#endif
+  } else {
+    r=std::fgets(ptr,n,fp);
+    if(feof(fp))   eof=true;
+    if(ferror(fp)) err=true;
+  }
+  return r;
+}
+
 IFile& IFile::advanceField() {
   plumed_assert(!inMiddleOfField);
   std::string line;
@@ -65,6 +86,13 @@ IFile& IFile::advanceField() {
   while(!done) {
     getline(line);
     if(!*this) {return *this;}
+// lines with data are split directly in the fields, without making a list of words
+    const size_t first=line.find_first_not_of(" \t");
+    if(first!=std::string::npos && line[first]!='#' && line.find_first_of("{}")==std::string::npos) {
+      splitFields(line);
+      done=true;
+      continue;
+    }
     std::vector<std::string> words=Tools::getWords(line);
     if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
       fields.clear();
@@ -102,6 +130,27 @@ IFile& IFile::advanceField() {
   return *this;
 }
 
+void IFile::splitFields(const std::string&line) {
+  const char* p=line.c_str();
+  unsigned i=0;
+  while(true) {
+    while(*p==' ' || *p=='\t') p++;
+// everything after # is a comment
+    if(*p=='\0' || *p=='#') break;
+    const char* q=p;
+    while(*q!='\0' && *q!=' ' && *q!='\t' && *q!='#') q++;
+    while(i<fields.size() && fields[i].constant) i++;
+    if(i>=fields.size()) plumed_merror(getPath() + " mismatch between number of fields in file and expected number");
+// the value is copied in the string that is already there, so that no memory is allocated
+    fields[i].value.assign(p,q-p);
+    fields[i].read=false;
+    i++;
+    p=q;
+  }
+  while(i<fields.size() && fields[i].constant) i++;
+  if(i<fields.size()) plumed_merror(getPath() + " mismatch between number of fields in file and expected number");
+}
+
 IFile& IFile::open(const std::string&path) {
   plumed_massert(!cloned,"file "+path+" appears to be cloned");
   eof=false;
@@ -132,11 +181,10 @@ IFile& IFile::scanFieldList(std::vector<std::string>&s) {
 }
 
 bool IFile::FieldExist(const std::string& s) {
-  std::vector<std::string> slist;
-  scanFieldList(slist);
-  int mycount = (int) std::count(slist.begin(), slist.end(), s);
-  if(mycount>0) return true;
-  else return false;
+  if(!inMiddleOfField) advanceField();
+  if(!*this) return false;
+  for(unsigned i=0; i<fields.size(); i++) if(fields[i].name==s) return true;
+  return false;
 }
 
 IFile& IFile::scanField(const std::string&name,std::string&str) {
@@ -149,16 +197,20 @@ IFile& IFile::scanField(const std::string&name,std::string&str) {
 }
 
 IFile& IFile::scanField(const std::string&name,double &x) {
-  std::string str;
-  scanField(name,str);
-  if(*this) Tools::convert(str,x);
+  if(!inMiddleOfField) advanceField();
+  if(!*this) return *this;
+  unsigned i=findField(name);
+  Tools::convert(fields[i].value,x);
+  fields[i].read=true;
   return *this;
 }
 
 IFile& IFile::scanField(const std::string&name,int &x) {
-  std::string str;
-  scanField(name,str);
-  if(*this) Tools::convert(str,x);
+  if(!inMiddleOfField) advanceField();
+  if(!*this) return *this;
+  unsigned i=findField(name);
+  Tools::convert(fields[i].value,x);
+  fields[i].read=true;
   return *this;
 }
 
@@ -190,7 +242,8 @@ IFile& IFile::scanField() {
 IFile::IFile():
   inMiddleOfField(false),
   ignoreFields(false),
-  noEOL(false)
+  noEOL(false),
+  nextField(0)
 {
 }
 
@@ -199,20 +252,27 @@ IFile::~IFile() {
 }
 
 IFile& IFile::getline(std::string &str) {
-  char tmp=0;
   str="";
   fpos_t pos;
   fgetpos(fp,&pos);
-  while(llread(&tmp,1)==1 && tmp && tmp!='\n' && tmp!='\r' && !eof && !err) {
-    str+=tmp;
+// the line is read in chunks rather than one character at a time
+  const int bufferlength=1024;
+  char buffer[bufferlength];
+  bool newline=false;
+  while(!eof && !err && llgets(buffer,bufferlength)) {
+    const size_t n=std::strlen(buffer);
+    str.append(buffer,n);
+    if(n>0 && buffer[n-1]=='\n') {newline=true; break;}
   }
-  if(tmp=='\r') {
-    llread(&tmp,1);
-    plumed_massert(tmp=='\n',"plumed only accepts \\n (unix) or \\r\\n (dos) new lines");
+  if(newline) str.erase(str.length()-1);
+  const size_t cr=str.find('\r');
+  if(cr!=std::string::npos) {
+    plumed_massert(newline && cr+1==str.length(),"plumed only accepts \\n (unix) or \\r\\n (dos) new lines");
+    str.erase(cr);
   }
   if(eof && noEOL) {
     if(str.length()>0) eof=false;
-  } else if(eof || err || tmp!='\n') {
+  } else if(eof || err || !newline) {
     eof = true;
     str="";
     if(!err) fsetpos(fp,&pos);
@@ -227,10 +287,16 @@ IFile& IFile::getline(std::string &str) {
   return *this;
 }
 
-unsigned IFile::findField(const std::string&name)const {
-  unsigned i;
-  for(i=0; i<fields.size(); i++) if(fields[i].name==name) break;
-  if(i>=fields.size()) plumed_merror(name);
+unsigned IFile::findField(const std::string&name) {
+  const unsigned n=fields.size();
+  const unsigned start=(nextField<n ? nextField : 0);
+  unsigned i=n;
+  for(unsigned k=0; k<n; k++) {
+    const unsigned j=(start+k<n ? start+k : start+k-n);
+    if(fields[j].name==name) {i=j; break;}
+  }
+  if(i>=n) plumed_merror(name);
+  nextField=i+1;
   return i;
 }
 
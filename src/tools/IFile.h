@@ -49,6 +49,8 @@ class IFile:
 /// Low-level read.
 /// Note: in parallel, all processes read
   size_t llread(char*,size_t);
+/// Low-level read of a line, or of its first n-1 characters if it is longer (as fgets)
+  bool llgets(char*,int n);
 /// All the defined fields
   std::vector<Field> fields;
 /// Flag set in the middle of a field reading
@@ -59,8 +61,13 @@ class IFile:
   bool noEOL;
 /// Advance to next field (= read one line)
   IFile& advanceField();
+/// Store the words of a line with data in the values of the fields
+  void splitFields(const std::string&line);
+/// Position where findField starts looking for the next field.
+/// Fields are usually read in the same order at every line, so that they are found immediately
+  unsigned nextField;
 /// Find field index by name
-  unsigned findField(const std::string&name)const;
+  unsigned findField(const std::string&name);
 public:
 /// Constructor
   IFile();
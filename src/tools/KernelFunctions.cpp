@@ -127,6 +127,15 @@ void KernelFunctions::setData( const std::vector<double>& at, const std::vector<
   width.resize( sig.size() ); for(unsigned i=0; i<sig.size(); ++i) width[i]=sig[i];
   diagonal=false;
   if (multivariate==false ) diagonal=true;
+  // Precompute the metric used when evaluating the kernel
+  if(diagonal) {
+    invwidth.resize( width.size() );
+    for(unsigned i=0; i<width.size(); ++i) invwidth[i]=1.0/width[i];
+  } else {
+    unsigned ncv=ndim(); Matrix<double> mymatrix( getMatrix() );
+    metric.resize( ncv*ncv );
+    for(unsigned i=0; i<ncv; ++i) for(unsigned j=0; j<ncv; ++j) metric[i*ncv+j]=mymatrix(i,j);
+  }
 
   // Setup the kernel type
   if(type=="GAUSSIAN" || type=="gaussian" || type=="TRUNCATED-GAUSSIAN" || type=="truncated-gaussian" ) {
@@ -228,27 +237,20 @@ double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<do
     if(pos[0]->get()<lowI_) pos[0]->set(lowI_);
     if(pos[0]->get()>uppI_) pos[0]->set(uppI_);
   }
-  double r2=0;
-  if(diagonal) {
-    for(unsigned i=0; i<ndim(); ++i) {
-      derivatives[i]=-pos[i]->difference( center[i] ) / width[i];
-      r2+=derivatives[i]*derivatives[i];
-      derivatives[i] /= width[i];
-    }
-  } else {
-    Matrix<double> mymatrix( getMatrix() );
-    for(unsigned i=0; i<mymatrix.nrows(); ++i) {
-      double dp_i, dp_j; derivatives[i]=0;
-      dp_i=-pos[i]->difference( center[i] );
-      for(unsigned j=0; j<mymatrix.ncols(); ++j) {
-        if(i==j) dp_j=dp_i;
-        else dp_j=-pos[j]->difference( center[j] );
-
-        derivatives[i]+=mymatrix(i,j)*dp_j;
-        r2+=dp_i*dp_j*mymatrix(i,j);
-      }
-    }
+  std::vector<double> dp( ndim() );
+  for(unsigned i=0; i<ndim(); ++i) dp[i]=-pos[i]->difference( center[i] );
+  double kval=evaluate( &dp[0], &derivatives[0] );
+  if(doInt) {
+    if((pos[0]->get() <= lowI_ || pos[0]->get() >= uppI_) && usederiv ) for(unsigned i=0; i<ndim(); ++i)derivatives[i]=0;
   }
+  return kval;
+}
+
+double KernelFunctions::evaluate( const double* dp, double* der ) const {
+  const unsigned ncv=ndim();
+  double r2;
+  if(diagonal) r2=2.0*halfDiagonalNorm2( ncv, &invwidth[0], dp, der );
+  else r2=2.0*halfMetricNorm2( ncv, &metric[0], dp, der );
   double kderiv, kval;
   if(ktype==gaussian) {
     kval=height*std::exp(-0.5*r2); kderiv=-kval;
@@ -256,8 +258,8 @@ double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<do
     double r=sqrt(r2);
     if(ktype==triangular) {
       if( r<1.0 ) {
-        if(r==0) kderiv=0;
-        kderiv=-1; kval=height*( 1. - fabs(r) );
+        kval=height*( 1. - fabs(r) );
+        kderiv=( r>0 ? -height / r : 0. );
       } else {
         kval=0.; kderiv=0.;
       }
@@ -268,15 +270,16 @@ double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<do
     } else {
       plumed_merror("Not a valid kernel type");
     }
-    kderiv*=height / r ;
-  }
-  for(unsigned i=0; i<ndim(); ++i) derivatives[i]*=kderiv;
-  if(doInt) {
-    if((pos[0]->get() <= lowI_ || pos[0]->get() >= uppI_) && usederiv ) for(unsigned i=0; i<ndim(); ++i)derivatives[i]=0;
   }
+  if(der) for(unsigned i=0; i<ncv; ++i) der[i]*=kderiv;
   return kval;
 }
 
+void KernelFunctions::evaluate( unsigned n, const double* dp, double* val, double* der ) const {
+  const unsigned ncv=ndim();
+  for(unsigned k=0; k<n; ++k) val[k]=evaluate( dp+k*ncv, der ? der+k*ncv : NULL );
+}
+
 KernelFunctions* KernelFunctions::read( IFile* ifile, const std::vector<std::string>& valnames ) {
   std::string sss; ifile->scanField("multivariate",sss);
   std::vector<double> cc( valnames.size() ), sig;
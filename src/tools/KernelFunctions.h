@@ -39,6 +39,10 @@ private:
   std::vector<double> center;
 /// The width of the kernel
   std::vector<double> width;
+/// Inverse of the widths, for diagonal kernels
+  std::vector<double> invwidth;
+/// Full metric matrix stored by rows, for non diagonal kernels
+  std::vector<double> metric;
 /// The height of the kernel
   double height;
 /// Used to set all the data in the kernel during construction - avoids double coding as this has two constructors
@@ -60,6 +64,18 @@ public:
   std::vector<double> getContinuousSupport( ) const;
 /// Evaluate the kernel function with constant intervals
   double evaluate( const std::vector<Value*>& pos, std::vector<double>& derivatives, bool usederiv=true, bool doInt=false, double lowI_=-1, double uppI_=-1 ) const;
+/// Evaluate the kernel at a point given its displacement from the center (point minus center, periodicity already applied).
+/// If der is not NULL, derivatives with respect to the point are stored there
+  double evaluate( const double* dp, double* der ) const;
+/// Evaluate the kernel at n points given their displacements from the center (ndim() numbers per point).
+/// Values are stored in val and, if der is not NULL, derivatives in der (ndim() numbers per point)
+  void evaluate( unsigned n, const double* dp, double* val, double* der ) const;
+/// Compute dp M dp / 2 for a symmetric ncv x ncv metric M stored by rows.
+/// If grad is not NULL, M dp is stored there (grad should not overlap with dp)
+  static double halfMetricNorm2( unsigned ncv, const double* metric, const double* dp, double* grad );
+/// Compute dp M dp / 2 for a diagonal metric with M_ii=invwidth[i]^2.
+/// If grad is not NULL, M dp is stored there (grad can be the same as dp)
+  static double halfDiagonalNorm2( unsigned ncv, const double* invwidth, const double* dp, double* grad );
 /// Read a kernel function from a file
   static KernelFunctions* read( IFile* ifile, const std::vector<std::string>& valnames );
 };
@@ -76,6 +92,32 @@ Matrix<double> KernelFunctions::getMatrix() const {
   return mymatrix;
 }
 
+inline
+double KernelFunctions::halfMetricNorm2( unsigned ncv, const double* metric, const double* dp, double* grad ) {
+  double dp2=0.0;
+  for(unsigned i=0; i<ncv; ++i) {
+    dp2+=dp[i]*dp[i]*metric[i*ncv+i]*0.5;
+    for(unsigned j=i+1; j<ncv; ++j) dp2+=dp[i]*dp[j]*metric[i*ncv+j];
+  }
+  if(grad) for(unsigned i=0; i<ncv; ++i) {
+      double tmp=0.0;
+      for(unsigned j=0; j<ncv; ++j) tmp+=metric[i*ncv+j]*dp[j];
+      grad[i]=tmp;
+    }
+  return dp2;
+}
+
+inline
+double KernelFunctions::halfDiagonalNorm2( unsigned ncv, const double* invwidth, const double* dp, double* grad ) {
+  double dp2=0.0;
+  for(unsigned i=0; i<ncv; ++i) {
+    const double x=dp[i]*invwidth[i];
+    dp2+=x*x;
+    if(grad) grad[i]=x*invwidth[i];
+  }
+  return 0.5*dp2;
+}
+
 inline
 unsigned KernelFunctions::ndim() const {
   return center.size();
@@ -252,6 +252,94 @@ template <typename T> int diagMat( const Matrix<T>& A, std::vector<double>& eige
   return 0;
 }
 
+/// Orthogonalize w to all the (orthonormal) vectors in basis and return the norm of what is left.
+/// This is done twice as once is not enough when w is almost in the space spanned by the basis.
+inline double orthogonalizeToBasis( const std::vector<std::vector<double> >& basis, std::vector<double>& w ) {
+  for(unsigned iter=0; iter<2; ++iter) {
+    for(unsigned i=0; i<basis.size(); ++i) {
+      double proj=0; for(unsigned j=0; j<w.size(); ++j) proj+=basis[i][j]*w[j];
+      for(unsigned j=0; j<w.size(); ++j) w[j]-=proj*basis[i][j];
+    }
+  }
+  double wnorm=0; for(unsigned j=0; j<w.size(); ++j) wnorm+=w[j]*w[j];
+  return sqrt(wnorm);
+}
+
+/// Find the k largest eigenvalues of the symmetric n by n matrix A and the corresponding eigenvectors
+/// using the Lanczos algorithm with full reorthogonalization.  A can be any object for which mult( A, x, y )
+/// calculates y=Ax for std::vectors x and y, so sparse matrices can be used and only need to be multiplied
+/// by a vector a few times.  The eigenvalues are returned in DECREASING order and the eigenvectors are
+/// stored ROW-WISE as in diagMat.  If warmstart is true the iterations start from the sum of the rows of
+/// eigenvecs, which should contain the eigenvectors found at a previous step.  Returns zero if it worked.
+template <typename M> int lanczos( const M& A, const unsigned& n, const unsigned& k, std::vector<double>& eigenvals, Matrix<double>& eigenvecs, const bool& warmstart=false ) {
+  plumed_assert( k>0 && k<=n );
+  const double tol=1.e-10;
+
+  std::vector<std::vector<double> > basis; std::vector<double> alpha, beta;
+  std::vector<double> q( n, 0.0 ), w( n ), theta; Matrix<double> tmat, y;
+  if( warmstart && eigenvecs.ncols()==n ) {
+    for(unsigned i=0; i<eigenvecs.nrows(); ++i) for(unsigned j=0; j<n; ++j) q[j]+=eigenvecs(i,j);
+  }
+  double qnorm=orthogonalizeToBasis( basis, q );
+
+  unsigned nrestart=0; double anorm=0; bool converged=false;
+  while( basis.size()<n && !converged ) {
+    if( qnorm<=tol ) {
+      // We need a new starting vector: this is deterministic so that results are reproducible
+      for(unsigned j=0; j<n; ++j) q[j]=std::sin( (j+1)*(nrestart+1)*0.6180339887498949 + nrestart );
+      nrestart++; qnorm=orthogonalizeToBasis( basis, q );
+      if( qnorm<=tol ) continue;
+    }
+    for(unsigned j=0; j<n; ++j) q[j]/=qnorm;
+    basis.push_back( q ); mult( A, q, w );
+
+    unsigned m=basis.size();
+    double a=0; for(unsigned j=0; j<n; ++j) a+=q[j]*w[j];
+    alpha.push_back( a ); double b=orthogonalizeToBasis( basis, w );
+    anorm=std::max( anorm, std::fabs(a) + b + ( m>1 ? beta[m-2] : 0 ) );
+    // The Krylov space is invariant under A if b is zero
+    bool breakdown=( b<=tol*anorm );
+    beta.push_back( breakdown ? 0 : b );
+
+    if( m>=k && ( breakdown || m%5==0 || m==n ) ) {
+      tmat.resize( m, m ); tmat=0;
+      for(unsigned i=0; i<m; ++i) {
+        tmat(i,i)=alpha[i];
+        if( i+1<m ) tmat(i,i+1)=tmat(i+1,i)=beta[i];
+      }
+      int info=diagMat( tmat, theta, y ); if( info!=0 ) return info;
+      // Eigenvalues that are not connected to the start vector are missed if we stop at a breakdown
+      // so we try a few more starting vectors (this also catches degenerate eigenvalues)
+      if( !breakdown || nrestart>=k || m==n ) {
+        converged=true;
+        for(unsigned i=m-k; i<m; ++i) {
+          if( std::fabs( beta[m-1]*y(i,m-1) )>tol*anorm ) { converged=false; break; }
+        }
+      }
+    }
+    if( breakdown ) qnorm=0;
+    else { q=w; qnorm=b; }
+  }
+  unsigned m=basis.size();
+  if( !converged ) return 1;
+
+  // Compute the Ritz vectors from the eigenvectors of the tridiagonal matrix
+  if( eigenvals.size()!=k ) eigenvals.resize( k );
+  if( eigenvecs.nrows()!=k || eigenvecs.ncols()!=n ) eigenvecs.resize( k, n );
+  eigenvecs=0;
+  for(unsigned i=0; i<k; ++i) {
+    eigenvals[i]=theta[m-1-i];
+    for(unsigned l=0; l<m; ++l) {
+      for(unsigned j=0; j<n; ++j) eigenvecs(i,j)+=y(m-1-i,l)*basis[l][j];
+    }
+    // Same convention as diagMat - the first non-null element is positive
+    unsigned j;
+    for(j=0; j<n; j++) if(eigenvecs(i,j)*eigenvecs(i,j)>1e-14) break;
+    if(j<n) if(eigenvecs(i,j)<0.0) for(j=0; j<n; j++) eigenvecs(i,j)*=-1;
+  }
+  return 0;
+}
+
 template <typename T> int pseudoInvert( const Matrix<T>& A, Matrix<double>& pseudoinverse ) {
   double *da=new double[A.sz]; unsigned k=0;
   // Transfer the matrix to the local array
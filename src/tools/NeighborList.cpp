@@ -24,6 +24,7 @@
 #include "Pbc.h"
 #include "AtomNumber.h"
 #include "Tools.h"
+#include "OpenMP.h"
 #include <vector>
 #include <algorithm>
 
@@ -32,9 +33,11 @@ using namespace std;
 
 NeighborList::NeighborList(const vector<AtomNumber>& list0, const vector<AtomNumber>& list1,
                            const bool& do_pair, const bool& do_pbc, const Pbc& pbc,
-                           const double& distance, const unsigned& stride): reduced(false),
+                           const double& distance, const unsigned& stride,
+                           const double& skin): reduced(false),
   do_pair_(do_pair), do_pbc_(do_pbc), pbc_(&pbc),
-  distance_(distance), stride_(stride)
+  distance_(distance), skin_(skin), stride_(stride), nupdates_(0),
+  linkcells_(serialcomm_)
 {
 // store full list of atoms needed
   fullatomlist_=list0;
@@ -54,9 +57,10 @@ NeighborList::NeighborList(const vector<AtomNumber>& list0, const vector<AtomNum
 
 NeighborList::NeighborList(const vector<AtomNumber>& list0, const bool& do_pbc,
                            const Pbc& pbc, const double& distance,
-                           const unsigned& stride): reduced(false),
+                           const unsigned& stride, const double& skin): reduced(false),
   do_pbc_(do_pbc), pbc_(&pbc),
-  distance_(distance), stride_(stride) {
+  distance_(distance), skin_(skin), stride_(stride), nupdates_(0),
+  linkcells_(serialcomm_) {
   fullatomlist_=list0;
   nlist0_=list0.size();
   twolists_=false;
@@ -91,47 +95,154 @@ pair<unsigned,unsigned> NeighborList::getIndexPair(unsigned ipair) {
   return index;
 }
 
+bool NeighborList::useLinkCells() const {
+// with PAIR the number of pairs is already linear in the number of atoms
+  if(twolists_ && do_pair_) return false;
+// link cells need a periodic box to be defined
+  if(!do_pbc_ || !pbc_->isSet()) return false;
+  return fullatomlist_.size()>=linkCellsMinAtoms;
+}
+
 void NeighborList::update(const vector<Vector>& positions) {
   neighbors_.clear();
-  const double d2=distance_*distance_;
 // check if positions array has the correct length
   plumed_assert(positions.size()==fullatomlist_.size());
-  for(unsigned int i=0; i<nallpairs_; ++i) {
-    pair<unsigned,unsigned> index=getIndexPair(i);
-    unsigned index0=index.first;
-    unsigned index1=index.second;
-    Vector distance;
+  if(useLinkCells()) updateLinkCells(positions);
+  else updateAllPairs(positions);
+  setRequestList();
+  if(skin_>0.0) reference_positions_=positions;
+  nupdates_++;
+}
+
+bool NeighborList::needsUpdate(const vector<Vector>& positions) const {
+  if(reference_positions_.size()!=positions.size()) return true;
+// two atoms approaching each other by half the skin each could cross the cutoff
+  const double maxdisp2=0.25*skin_*skin_;
+  for(unsigned i=0; i<positions.size(); ++i) {
+    Vector displacement;
     if(do_pbc_) {
-      distance=pbc_->distance(positions[index0],positions[index1]);
+      displacement=pbc_->distance(reference_positions_[i],positions[i]);
     } else {
-      distance=delta(positions[index0],positions[index1]);
+      displacement=delta(reference_positions_[i],positions[i]);
     }
-    double value=modulo2(distance);
-    if(value<=d2) {neighbors_.push_back(index);}
+    if(modulo2(displacement)>maxdisp2) return true;
   }
-  setRequestList();
+  return false;
+}
+
+unsigned NeighborList::getNumThreads(unsigned nitems) const {
+// avoid spawning threads for lists that are too small
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*minItemsPerThread>nitems) nt=nitems/minItemsPerThread;
+  if(nt==0) nt=1;
+  return nt;
+}
+
+void NeighborList::updateAllPairs(const vector<Vector>& positions) {
+  const double d2=(distance_+skin_)*(distance_+skin_);
+  const unsigned nt=getNumThreads(nallpairs_);
+  vector<vector<pair<unsigned,unsigned> > > omp_neighbors(nt);
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<pair<unsigned,unsigned> > & mypairs(omp_neighbors[OpenMP::getThreadNum()]);
+// a static schedule gives each thread a single contiguous chunk, in thread order
+    #pragma omp for schedule(static)
+    for(unsigned int i=0; i<nallpairs_; ++i) {
+      pair<unsigned,unsigned> index=getIndexPair(i);
+      unsigned index0=index.first;
+      unsigned index1=index.second;
+      Vector distance;
+      if(do_pbc_) {
+        distance=pbc_->distance(positions[index0],positions[index1]);
+      } else {
+        distance=delta(positions[index0],positions[index1]);
+      }
+      double value=modulo2(distance);
+      if(value<=d2) {mypairs.push_back(index);}
+    }
+  }
+// so that concatenating the chunks reproduces the serial order
+  for(unsigned t=0; t<nt; ++t) neighbors_.insert(neighbors_.end(),omp_neighbors[t].begin(),omp_neighbors[t].end());
+}
+
+void NeighborList::updateLinkCells(const vector<Vector>& positions) {
+  const double d2=(distance_+skin_)*(distance_+skin_);
+// atoms in the second list (or all atoms if there is a single list) are sorted into cells
+  const unsigned first=(twolists_ ? nlist0_ : 0);
+  const unsigned ncelled=positions.size()-first;
+  vector<Vector> ltmp_pos(ncelled);
+  vector<unsigned> ltmp_ind(ncelled);
+  for(unsigned i=0; i<ncelled; ++i) {
+    ltmp_pos[i]=positions[first+i];
+    ltmp_ind[i]=first+i;
+  }
+  linkcells_.setCutoff(distance_+skin_);
+  linkcells_.buildCellLists(ltmp_pos,ltmp_ind,*pbc_);
+
+  const unsigned nt=getNumThreads(nlist0_);
+  vector<vector<pair<unsigned,unsigned> > > omp_neighbors(nt);
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<pair<unsigned,unsigned> > & mypairs(omp_neighbors[OpenMP::getThreadNum()]);
+    vector<unsigned> cells_required(linkcells_.getNumberOfCells()), atoms(1+ncelled), mylist;
+    #pragma omp for schedule(static)
+    for(unsigned i=0; i<nlist0_; ++i) {
+      unsigned ncells_required=0, natoms=1; atoms[0]=i;
+      linkcells_.addRequiredCells(linkcells_.findMyCell(positions[i]),ncells_required,cells_required);
+      linkcells_.retrieveAtomsInCells(ncells_required,cells_required,natoms,atoms);
+      mylist.clear();
+      for(unsigned k=1; k<natoms; ++k) {
+        unsigned j=atoms[k];
+// with a single list each pair is only counted once
+        if(!twolists_ && j<i) continue;
+        if(modulo2(pbc_->distance(positions[i],positions[j]))<=d2) mylist.push_back(j);
+      }
+// sorting makes the order of the pairs identical to the one obtained looping over all pairs
+      std::sort(mylist.begin(),mylist.end());
+      for(unsigned k=0; k<mylist.size(); ++k) mypairs.push_back(pair<unsigned,unsigned>(i,mylist[k]));
+    }
+  }
+  for(unsigned t=0; t<nt; ++t) neighbors_.insert(neighbors_.end(),omp_neighbors[t].begin(),omp_neighbors[t].end());
 }
 
 void NeighborList::setRequestList() {
   requestlist_.clear();
-  for(unsigned int i=0; i<size(); ++i) {
-    requestlist_.push_back(fullatomlist_[neighbors_[i].first]);
-    requestlist_.push_back(fullatomlist_[neighbors_[i].second]);
+  const unsigned nn=size();
+  const unsigned nt=getNumThreads(nn);
+  vector<vector<AtomNumber> > omp_requestlist(nt);
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<AtomNumber> & mylist(omp_requestlist[OpenMP::getThreadNum()]);
+    #pragma omp for schedule(static)
+    for(unsigned int i=0; i<nn; ++i) {
+      mylist.push_back(fullatomlist_[neighbors_[i].first]);
+      mylist.push_back(fullatomlist_[neighbors_[i].second]);
+    }
+    Tools::removeDuplicates(mylist);
   }
+  for(unsigned t=0; t<nt; ++t) requestlist_.insert(requestlist_.end(),omp_requestlist[t].begin(),omp_requestlist[t].end());
   Tools::removeDuplicates(requestlist_);
   reduced=false;
 }
 
 vector<AtomNumber>& NeighborList::getReducedAtomList() {
-  if(!reduced)for(unsigned int i=0; i<size(); ++i) {
+  if(!reduced) {
+    const unsigned nn=size();
+    const unsigned nt=getNumThreads(nn);
+// errors cannot be thrown from inside the parallel region, so they are checked after it
+    bool found=true;
+    #pragma omp parallel for num_threads(nt) reduction(&&:found)
+    for(unsigned int i=0; i<nn; ++i) {
       unsigned newindex0=0,newindex1=0;
       AtomNumber index0=fullatomlist_[neighbors_[i].first];
       AtomNumber index1=fullatomlist_[neighbors_[i].second];
 // I exploit the fact that requestlist_ is an ordered vector
-      auto p = std::find(requestlist_.begin(), requestlist_.end(), index0); plumed_assert(p!=requestlist_.end()); newindex0=p-requestlist_.begin();
-      p = std::find(requestlist_.begin(), requestlist_.end(), index1); plumed_assert(p!=requestlist_.end()); newindex1=p-requestlist_.begin();
+      auto p = std::lower_bound(requestlist_.begin(), requestlist_.end(), index0); found=found && p!=requestlist_.end() && *p==index0; newindex0=p-requestlist_.begin();
+      p = std::lower_bound(requestlist_.begin(), requestlist_.end(), index1); found=found && p!=requestlist_.end() && *p==index1; newindex1=p-requestlist_.begin();
       neighbors_[i]=pair<unsigned,unsigned>(newindex0,newindex1);
     }
+    plumed_assert(found);
+  }
   reduced=true;
   return requestlist_;
 }
@@ -140,6 +251,14 @@ unsigned NeighborList::getStride() const {
   return stride_;
 }
 
+double NeighborList::getSkin() const {
+  return skin_;
+}
+
+unsigned NeighborList::getNumberOfUpdates() const {
+  return nupdates_;
+}
+
 unsigned NeighborList::getLastUpdate() const {
   return lastupdate_;
 }
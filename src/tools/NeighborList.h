@@ -24,6 +24,8 @@
 
 #include "Vector.h"
 #include "AtomNumber.h"
+#include "Communicator.h"
+#include "LinkCells.h"
 
 #include <vector>
 
@@ -35,15 +37,33 @@ class Pbc;
 /// A class that implements neighbor lists from two lists or a single list of atoms
 class NeighborList
 {
+/// Minimum number of atoms for which link cells are used to rebuild the list
+  static const unsigned linkCellsMinAtoms=1000;
+/// Minimum number of pairs or atoms handled by each thread when building the list
+  static const unsigned minItemsPerThread=1000;
   bool reduced;
   bool do_pair_,do_pbc_,twolists_;
   const PLMD::Pbc* pbc_;
   std::vector<PLMD::AtomNumber> fullatomlist_,requestlist_;
   std::vector<std::pair<unsigned,unsigned> > neighbors_;
-  double distance_;
-  unsigned stride_,nlist0_,nlist1_,nallpairs_,lastupdate_;
+  double distance_,skin_;
+  unsigned stride_,nlist0_,nlist1_,nallpairs_,lastupdate_,nupdates_;
+/// Positions of the atoms at the last update, used when a skin is set
+  std::vector<PLMD::Vector> reference_positions_;
+/// A serial communicator, as every rank builds the full list
+  Communicator serialcomm_;
+/// Link cells used to rebuild the list for large numbers of atoms
+  LinkCells linkcells_;
 /// Initialize the neighbor list with all possible pairs
   void initialize();
+/// Number of threads to be used for a loop over nitems elements
+  unsigned getNumThreads(unsigned nitems) const;
+/// Decide whether the list should be rebuilt using link cells
+  bool useLinkCells() const;
+/// Rebuild the list looping over all possible pairs
+  void updateAllPairs(const std::vector<PLMD::Vector>& positions);
+/// Rebuild the list looping over the atoms in neighboring link cells
+  void updateLinkCells(const std::vector<PLMD::Vector>& positions);
 /// Return the pair of indexes in the positions array
 /// of the two atoms forming the i-th pair among all possible pairs
   std::pair<unsigned,unsigned> getIndexPair(unsigned i);
@@ -53,10 +73,11 @@ public:
   NeighborList(const std::vector<PLMD::AtomNumber>& list0,
                const std::vector<PLMD::AtomNumber>& list1,
                const bool& do_pair, const bool& do_pbc, const PLMD::Pbc& pbc,
-               const double& distance=1.0e+30, const unsigned& stride=0);
+               const double& distance=1.0e+30, const unsigned& stride=0,
+               const double& skin=0.0);
   NeighborList(const std::vector<PLMD::AtomNumber>& list0, const bool& do_pbc,
                const PLMD::Pbc& pbc, const double& distance=1.0e+30,
-               const unsigned& stride=0);
+               const unsigned& stride=0, const double& skin=0.0);
 /// Return the list of all atoms. These are needed to rebuild the neighbor list.
   std::vector<PLMD::AtomNumber>& getFullAtomList();
 /// Update the indexes in the neighbor list to match the
@@ -68,6 +89,14 @@ public:
   void update(const std::vector<PLMD::Vector>& positions);
 /// Get the update stride of the neighbor list
   unsigned getStride() const;
+/// Get the skin of the neighbor list.
+/// When it is larger than zero, pairs are included up to distance+skin
+/// and the list is updated only when needsUpdate() returns true
+  double getSkin() const;
+/// Check if some atom moved by more than half the skin since the last update
+  bool needsUpdate(const std::vector<PLMD::Vector>& positions) const;
+/// Get the number of times the neighbor list was updated
+  unsigned getNumberOfUpdates() const;
 /// Get the last step in which the neighbor list was updated
   unsigned getLastUpdate() const;
 /// Set the step of the last update
@@ -26,6 +26,7 @@
 #include "core/Value.h"
 #include "Communicator.h"
 #include "Tools.h"
+#include "AsyncWriter.h"
 #include <cstdarg>
 #include <cstring>
 
@@ -40,20 +41,34 @@
 
 namespace PLMD {
 
-size_t OFile::llwrite(const char*ptr,size_t s) {
+size_t OFile::rawWrite(const char*ptr,size_t s) {
   size_t r;
-  if(linked) return linked->llwrite(ptr,s);
-  if(! (comm && comm->Get_rank()>0)) {
-    if(!fp) plumed_merror("writing on uninitilized File");
-    if(gzfp) {
+  if(gzfp) {
 #ifdef __PLUMED_HAS_ZLIB
-      r=gzwrite(gzFile(gzfp),ptr,s);
+    r=gzwrite(gzFile(gzfp),ptr,s);
 #else
-      plumed_merror("trying to use a gz file without zlib being linked");
+    plumed_merror("trying to use a gz file without zlib being linked");
 #endif
-    } else {
-      r=fwrite(ptr,1,s,fp);
+  } else {
+    r=fwrite(ptr,1,s,fp);
+  }
+  return r;
+}
+
+size_t OFile::llwrite(const char*ptr,size_t s) {
+  size_t r;
+  if(linked) return linked->llwrite(ptr,s);
+// in the background all the data is written, so there is no need to communicate the result
+  if(async) {
+    if(! (comm && comm->Get_rank()>0)) {
+      if(!fp) plumed_merror("writing on uninitilized File");
+      async->write(*this,ptr,s);
     }
+    return s;
+  }
+  if(! (comm && comm->Get_rank()>0)) {
+    if(!fp) plumed_merror("writing on uninitilized File");
+    r=rawWrite(ptr,s);
   }
 //  This barrier is apparently useless since it comes
 //  just before a Bcast.
@@ -70,7 +85,10 @@ size_t OFile::llwrite(const char*ptr,size_t s) {
 
 OFile::OFile():
   linked(NULL),
+  async(NULL),
+  asyncPending(0),
   fieldChanged(false),
+  nfields(0),
   backstring("bck"),
   enforceRestart_(false),
   enforceBackup_(false)
@@ -87,6 +105,7 @@ OFile::OFile():
 }
 
 OFile::~OFile() {
+  if(async) async->wait(*this);
   delete [] buffer_string;
   delete [] buffer;
 }
@@ -98,6 +117,12 @@ OFile& OFile::link(OFile&l) {
   return *this;
 }
 
+OFile& OFile::setAsyncWriter(AsyncWriter*a) {
+  if(async) async->wait(*this);
+  async=a;
+  return *this;
+}
+
 OFile& OFile::setLinePrefix(const std::string&l) {
   linePrefix=l;
   return *this;
@@ -151,6 +176,7 @@ OFile& OFile::addConstantField(const std::string&name) {
 
 OFile& OFile::clearFields() {
   fields.clear();
+  nfields=0;
   const_fields.clear();
   previous_fields.clear();
   return *this;
@@ -168,29 +194,33 @@ OFile& OFile::fmtField() {
 
 OFile& OFile::printField(const std::string&name,double v) {
   sprintf(buffer_string,fieldFmt.c_str(),v);
-  printField(name,buffer_string);
+  setField(name,buffer_string);
   return *this;
 }
 
 OFile& OFile::printField(const std::string&name,int v) {
   sprintf(buffer_string," %d",v);
-  printField(name,buffer_string);
+  setField(name,buffer_string);
   return *this;
 }
 
 OFile& OFile::printField(const std::string&name,const std::string & v) {
+  setField(name,v.c_str());
+  return *this;
+}
+
+void OFile::setField(const std::string&name,const char*v) {
   unsigned i;
   for(i=0; i<const_fields.size(); i++) if(const_fields[i].name==name) break;
   if(i>=const_fields.size()) {
-    Field field;
-    field.name=name;
-    field.value=v;
-    fields.push_back(field);
+    if(nfields==fields.size()) fields.push_back(Field());
+    fields[nfields].name=name;
+    fields[nfields].value=v;
+    nfields++;
   } else {
     if(const_fields[i].value!=v) fieldChanged=true;
     const_fields[i].value=v;
   }
-  return *this;
 }
 
 OFile& OFile::setupPrintValue( Value *val ) {
@@ -213,9 +243,9 @@ OFile& OFile::printField( Value* val, const double& v ) {
 
 OFile& OFile::printField() {
   bool reprint=false;
-  if(fieldChanged || fields.size()!=previous_fields.size()) {
+  if(fieldChanged || nfields!=previous_fields.size()) {
     reprint=true;
-  } else for(unsigned i=0; i<fields.size(); i++) {
+  } else for(unsigned i=0; i<nfields; i++) {
       if( previous_fields[i].name!=fields[i].name ||
           (fields[i].constant && fields[i].value!=previous_fields[i].value) ) {
         reprint=true;
@@ -224,17 +254,20 @@ OFile& OFile::printField() {
     }
   if(reprint) {
     printf("#! FIELDS");
-    for(unsigned i=0; i<fields.size(); i++) printf(" %s",fields[i].name.c_str());
+    for(unsigned i=0; i<nfields; i++) printf(" %s",fields[i].name.c_str());
     printf("\n");
     for(unsigned i=0; i<const_fields.size(); i++) {
       printf("#! SET %s %s",const_fields[i].name.c_str(),const_fields[i].value.c_str());
       printf("\n");
     }
   }
-  for(unsigned i=0; i<fields.size(); i++) printf("%s",fields[i].value.c_str());
-  printf("\n");
-  previous_fields=fields;
-  fields.clear();
+// the line is written at once, rather than one field at a time
+  fieldLine.clear();
+  for(unsigned i=0; i<nfields; i++) fieldLine+=fields[i].value;
+  fieldLine+='\n';
+  printf("%s",fieldLine.c_str());
+  previous_fields.assign(fields.begin(),fields.begin()+nfields);
+  nfields=0;
   fieldChanged=false;
   return *this;
 }
@@ -317,7 +350,10 @@ OFile& OFile::open(const std::string&path) {
 #endif
     }
   }
-  if(plumed) plumed->insertFile(*this);
+  if(plumed) {
+    plumed->insertFile(*this);
+    setAsyncWriter(plumed->asyncWriter);
+  }
   return *this;
 }
 
@@ -326,6 +362,7 @@ OFile& OFile::rewind() {
 // the reason is that normal rewind does not work when in append mode
 // moreover, we can take a backup of the file
   plumed_assert(fp);
+  if(async) async->wait(*this);
   clearFields();
   if(gzfp) {
 #ifdef __PLUMED_HAS_ZLIB
@@ -350,6 +387,8 @@ OFile& OFile::rewind() {
 }
 
 FileBase& OFile::flush() {
+// flushing makes sure that everything that has been written is on disk
+  if(async) async->wait(*this);
   if(heavyFlush) {
     if(gzfp) {
 #ifdef __PLUMED_HAS_ZLIB
@@ -372,6 +411,11 @@ FileBase& OFile::flush() {
   return *this;
 }
 
+void OFile::close() {
+  setAsyncWriter(NULL);
+  FileBase::close();
+}
+
 bool OFile::checkRestart()const {
   if(enforceRestart_) return true;
   else if(enforceBackup_) return false;
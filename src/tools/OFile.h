@@ -29,6 +29,7 @@
 namespace PLMD {
 
 class Value;
+class AsyncWriter;
 
 /**
 \ingroup TOOLBOX
@@ -163,6 +164,13 @@ class OFile:
   };
 /// Low-level write
   size_t llwrite(const char*,size_t);
+/// Write directly on the file, without going through the asynchronous writer
+  size_t rawWrite(const char*,size_t);
+/// Writer used to write the file in the background. NULL if the file is written directly
+  AsyncWriter* async;
+/// Number of records of this file that are still in the buffer of the asynchronous writer
+  unsigned asyncPending;
+  friend class AsyncWriter;
 /// True if fields has changed.
 /// This could be due to a change in the list of fields or a reset
 /// of a nominally constant field
@@ -171,8 +179,15 @@ class OFile:
   std::string fieldFmt;
 /// All the previously defined variable fields
   std::vector<Field> previous_fields;
-/// All the defined variable fields
+/// All the defined variable fields.
+/// Only the first nfields are set in the current line, the others are kept so that their strings are reused
   std::vector<Field> fields;
+/// Number of variable fields set in the current line
+  unsigned nfields;
+/// The line written by printField()
+  std::string fieldLine;
+/// Set the value of a field
+  void setField(const std::string&name,const char*v);
 /// All the defined constant fields
   std::vector<Field> const_fields;
 /// Prefix for line (e.g. "PLUMED: ")
@@ -257,6 +272,11 @@ public:
   OFile&rewind();
 /// Flush a file
   virtual FileBase&flush();
+/// Close a file, after everything written in the background has reached it
+  virtual void close();
+/// Write the file in the background with an AsyncWriter (NULL to write it directly).
+/// Files opened with open() use the writer of the linked PlumedMain object, if any
+  OFile&setAsyncWriter(AsyncWriter*);
 /// Enforce restart, also if the attached plumed object is not restarting.
 /// Useful for tests
   OFile&enforceRestart();
@@ -22,6 +22,8 @@
 
 #include "OpenMP.h"
 #include "Tools.h"
+#include "Vector.h"
+#include "Tensor.h"
 #include <cstdlib>
 #if defined(_OPENMP)
 #include <omp.h>
@@ -49,6 +51,22 @@ unsigned OpenMP::getThreadNum() {
 #endif
 }
 
+template<typename T>
+void OpenMP::sumOverThreads(const std::vector<std::vector<T> > & buffers,std::vector<T> & result) {
+  const unsigned n=result.size();
+  const unsigned nbuffers=buffers.size();
+// all the buffers should be complete before anyone starts reading them
+  #pragma omp barrier
+  #pragma omp for schedule(static)
+  for(unsigned i=0; i<n; ++i) {
+    for(unsigned t=0; t<nbuffers; ++t) if(buffers[t].size()==n) result[i]+=buffers[t][i];
+  }
+}
+
+template void OpenMP::sumOverThreads(const std::vector<std::vector<double> > &,std::vector<double> &);
+template void OpenMP::sumOverThreads(const std::vector<std::vector<Vector> > &,std::vector<Vector> &);
+template void OpenMP::sumOverThreads(const std::vector<std::vector<Tensor> > &,std::vector<Tensor> &);
+
 
 
 }
@@ -47,6 +47,17 @@ public:
   template<typename T>
   static unsigned getGoodNumThreads(const std::vector<T> & v);
 
+/// Sum the thread-private arrays buffers[i] into result.
+/// It should be called by all the threads of a parallel region, after they
+/// have filled their own buffer. Each thread then sums a contiguous block of elements
+/// over all the buffers, so that no critical section is needed and the
+/// result does not depend on the order in which threads complete.
+/// Buffers with a size different from result (e.g. belonging to threads
+/// that were not spawned) are ignored.
+/// It is available for double, Vector and Tensor.
+  template<typename T>
+  static void sumOverThreads(const std::vector<std::vector<T> > & buffers,std::vector<T> & result);
+
 };
 
 template<typename T>
@@ -0,0 +1,110 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2017 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Profiler.h"
+#include "Exception.h"
+#include "File.h"
+
+namespace PLMD {
+
+/// Quote a string for JSON or CSV output.
+/// In JSON, quotes and backslashes are escaped with a backslash, in CSV quotes are doubled
+static std::string quote(const std::string&s,bool json) {
+  std::string r("\"");
+  for(unsigned i=0; i<s.length(); i++) {
+    if(s[i]=='"') r+=(json?"\\\"":"\"\"");
+    else if(json && s[i]=='\\') r+="\\\\";
+    else r+=s[i];
+  }
+  return r+"\"";
+}
+
+void Profiler::start(const std::string&name) {
+  Timer & t(timers[name]);
+  plumed_massert(!t.running,"timer "+name+" is already running");
+  t.running=true;
+  t.lastStart=std::chrono::high_resolution_clock::now();
+}
+
+void Profiler::stop(const std::string&name) {
+  Timer & t(timers[name]);
+  plumed_massert(t.running,"timer "+name+" is not running");
+  t.running=false;
+  long long int lap=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-t.lastStart).count();
+  t.window+=lap;
+  t.total+=lap;
+  if(lap>t.max) t.max=lap;
+  t.calls++;
+  t.totalCalls++;
+}
+
+void Profiler::count(const std::string&name,unsigned long long n) {
+  Counter & c(counters[name]);
+  c.window+=n;
+  c.total+=n;
+  c.calls++;
+}
+
+void Profiler::resetWindow() {
+  for(auto & t : timers) {
+    t.second.window=0;
+    t.second.max=0;
+    t.second.calls=0;
+  }
+  for(auto & c : counters) {
+    c.second.window=0;
+    c.second.calls=0;
+  }
+}
+
+void Profiler::writeJSON(OFile&ofile,long int step)const {
+  ofile.printf("{\"step\":%ld,\"timers\":{",step);
+  bool first=true;
+  for(const auto & t : timers) {
+    ofile.printf("%s%s:{\"calls\":%llu,\"window\":%.9f,\"max\":%.9f,\"total\":%.9f,\"total_calls\":%llu}",
+                 (first?"":","),quote(t.first,true).c_str(),t.second.calls,
+                 t.second.window*1e-9,t.second.max*1e-9,t.second.total*1e-9,t.second.totalCalls);
+    first=false;
+  }
+  ofile.printf("},\"counters\":{");
+  first=true;
+  for(const auto & c : counters) {
+    ofile.printf("%s%s:{\"calls\":%llu,\"window\":%llu,\"total\":%llu}",
+                 (first?"":","),quote(c.first,true).c_str(),c.second.calls,c.second.window,c.second.total);
+    first=false;
+  }
+  ofile.printf("}}\n");
+}
+
+void Profiler::writeCSV(OFile&ofile,long int step) {
+  if(nwrittenCSV==0) ofile.printf("step,type,name,calls,window,max,total\n");
+  for(const auto & t : timers) {
+    ofile.printf("%ld,timer,%s,%llu,%.9f,%.9f,%.9f\n",step,quote(t.first,false).c_str(),
+                 t.second.calls,t.second.window*1e-9,t.second.max*1e-9,t.second.total*1e-9);
+  }
+  for(const auto & c : counters) {
+    ofile.printf("%ld,counter,%s,%llu,%llu,,%llu\n",step,quote(c.first,false).c_str(),
+                 c.second.calls,c.second.window,c.second.total);
+  }
+  nwrittenCSV++;
+}
+
+}
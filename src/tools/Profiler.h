@@ -0,0 +1,97 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2017 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_Profiler_h
+#define __PLUMED_tools_Profiler_h
+#include <string>
+#include <map>
+#include <chrono>
+
+namespace PLMD {
+
+class OFile;
+
+/**
+\ingroup TOOLBOX
+Class collecting timings and counters over a window of steps.
+
+Contrary to Stopwatch, which only reports at the end of the run,
+this class is meant to be written periodically. Each timer and counter
+keeps track of the values accumulated since the last call to resetWindow(),
+together with the values accumulated since the beginning.
+Timers and counters are identified by their name and are created the
+first time they are used.
+\verbatim
+Profiler p;
+for(int i=0;i<100;i++){
+  p.start("loop");
+// do calculation
+  p.count("iterations");
+  p.stop("loop");
+  if(i%10==0) {
+    p.writeCSV(ofile,i);
+    p.resetWindow();
+  }
+}
+\endverbatim
+*/
+class Profiler {
+/// A single timer
+  class Timer {
+  public:
+    std::chrono::time_point<std::chrono::high_resolution_clock> lastStart;
+    long long int window = 0;
+    long long int total = 0;
+    long long int max = 0;
+    unsigned long long calls = 0;
+    unsigned long long totalCalls = 0;
+    bool running = false;
+  };
+/// A single counter
+  class Counter {
+  public:
+    unsigned long long window = 0;
+    unsigned long long total = 0;
+    unsigned long long calls = 0;
+  };
+  std::map<std::string,Timer> timers;
+  std::map<std::string,Counter> counters;
+/// Number of lines written in CSV format, used to write the header once
+  unsigned long long nwrittenCSV = 0;
+public:
+/// Start timer named "name"
+  void start(const std::string&name);
+/// Stop timer named "name"
+  void stop(const std::string&name);
+/// Increment counter named "name" by n
+  void count(const std::string&name,unsigned long long n=1);
+/// Reset the values accumulated in the current window
+  void resetWindow();
+/// Write the current window as a single JSON object on one line
+  void writeJSON(OFile&,long int step)const;
+/// Write the current window in CSV format, one line per timer or counter.
+/// The header is written the first time
+  void writeCSV(OFile&,long int step);
+};
+
+}
+
+#endif
@@ -399,6 +399,46 @@ double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
   }
 }
 
+void SwitchingFunction::calculateSqr(unsigned n,const double*distance2,double*result,double*dfunc)const {
+  plumed_massert(init,"you are trying to use an unset SwitchingFunction");
+  if(type==rational && nn%2==0 && mm%2==0 && d0==0.0 && 2*nn==mm) {
+// same as do_rational() with 2*N==M, working on the squared distance
+    const int nhalf=nn/2;
+    #pragma omp simd
+    for(unsigned i=0; i<n; ++i) {
+      const double rdist_2=distance2[i]*invr0_2;
+      double rNdist=1.0;
+      for(int k=1; k<nhalf; ++k) rNdist*=rdist_2;
+      const double iden=1.0/(1.0+rNdist*rdist_2);
+      const bool inside=(distance2[i]<=dmax_2);
+      result[i]=(inside ? iden*stretch+shift : 0.0);
+      dfunc[i]=(inside ? -nhalf*rNdist*iden*iden*2*invr0_2*stretch : 0.0);
+    }
+  } else if(type==exponential && d0==0.0) {
+    #pragma omp simd
+    for(unsigned i=0; i<n; ++i) {
+      const double distance=std::sqrt(distance2[i]);
+      const double value=std::exp(-distance*invr0);
+      const bool inside=(distance<=dmax);
+      const bool positive=(distance>0.0);
+      result[i]=(inside ? (positive ? value : 1.0)*stretch+shift : 0.0);
+      dfunc[i]=(inside && positive ? -value*invr0/distance*stretch : 0.0);
+    }
+  } else if(type==gaussian && d0==0.0) {
+// the square root is not needed here
+    #pragma omp simd
+    for(unsigned i=0; i<n; ++i) {
+      const double value=std::exp(-0.5*distance2[i]*invr0_2);
+      const bool inside=(distance2[i]<=dmax_2);
+      const bool positive=(distance2[i]>0.0);
+      result[i]=(inside ? (positive ? value : 1.0)*stretch+shift : 0.0);
+      dfunc[i]=(inside && positive ? -value*invr0_2*stretch : 0.0);
+    }
+  } else {
+    for(unsigned i=0; i<n; ++i) result[i]=calculateSqr(distance2[i],dfunc[i]);
+  }
+}
+
 double SwitchingFunction::calculate(double distance,double&dfunc)const {
   plumed_massert(init,"you are trying to use an unset SwitchingFunction");
   if(distance>dmax) {
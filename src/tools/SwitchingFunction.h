@@ -114,6 +114,13 @@ public:
 /// The advantage is that in some case the expensive square root can be avoided
 /// (namely for rational functions, if nn and mm are even and d0 is zero)
   double calculateSqr(double distance2,double&dfunc)const;
+/// Compute the switching function on n squared distances at once.
+/// Equivalent to calling calculateSqr() on each element of distance2,
+/// storing the results in result and the derivatives in dfunc.
+/// The type of the function is only checked once, and for rational functions with
+/// even exponents and 2*nn==mm, exponential and gaussian functions (with d0 zero)
+/// the loop is branch free so that it can be vectorized by the compiler.
+  void calculateSqr(unsigned n,const double*distance2,double*result,double*dfunc)const;
 /// Returns d0
   double get_d0() const;
 /// Returns r0
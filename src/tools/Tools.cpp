@@ -24,9 +24,12 @@
 #include "Exception.h"
 #include "IFile.h"
 #include "lepton/Lepton.h"
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <dirent.h>
 #include <iostream>
+#include <limits>
 #include <map>
 
 using namespace std;
@@ -48,6 +51,35 @@ static std::map<string, double> leptonConstants= {
   {"sqrt1_2", std::sqrt(0.5)}
 };
 
+/// Read a plain number (e.g. a column of a file) with strtod, which is much faster than a stringstream.
+/// Returns false if the string should be read with the general method (e.g. "pi" or an expression)
+static bool fastConvert(const string & str,double & t) {
+  if(str.empty() || str.find_first_not_of(" \t0123456789+-.eE")!=string::npos) return false;
+  const char* p=str.c_str();
+  char* end;
+  errno=0;
+  double x=std::strtod(p,&end);
+  if(end==p || errno==ERANGE) return false;
+  while(*end==' ' || *end=='\t') end++;
+  if(*end!='\0') return false;
+  t=x;
+  return true;
+}
+
+/// Read a plain integer with strtol, returns false if the string should be read with the general method
+static bool fastConvert(const string & str,int & t) {
+  if(str.empty() || str.find_first_not_of(" \t0123456789+-")!=string::npos) return false;
+  const char* p=str.c_str();
+  char* end;
+  errno=0;
+  long x=std::strtol(p,&end,10);
+  if(end==p || errno==ERANGE || x<std::numeric_limits<int>::min() || x>std::numeric_limits<int>::max()) return false;
+  while(*end==' ' || *end=='\t') end++;
+  if(*end!='\0') return false;
+  t=x;
+  return true;
+}
+
 template<class T>
 bool Tools::convertToAny(const string & str,T & t) {
   istringstream istr(str.c_str());
@@ -59,6 +91,7 @@ bool Tools::convertToAny(const string & str,T & t) {
 }
 
 bool Tools::convert(const string & str,int & t) {
+  if(fastConvert(str,t)) return true;
   return convertToAny(str,t);
 }
 
@@ -120,6 +153,7 @@ bool Tools::convert(const string & str,float & t) {
 }
 
 bool Tools::convert(const string & str,double & t) {
+  if(fastConvert(str,t)) return true;
   return convertToReal(str,t);
 }
 
@@ -30,6 +30,8 @@
 #include "StoreDataVessel.h"
 #include "tools/OpenMP.h"
 #include "tools/Stopwatch.h"
+#include "tools/Profiler.h"
+#include "core/PlumedMain.h"
 
 using namespace std;
 namespace PLMD {
@@ -263,6 +265,8 @@ void ActionWithVessel::runAllTasks() {
   doJobsRequiredBeforeTaskList();
   if(timers) stopwatch.stop("1 Prepare Tasks");
 
+  if(plumed.profiler) plumed.profiler->count(getLabel()+" tasks",(nactive_tasks>rank ? (nactive_tasks-rank+stride-1)/stride : 0));
+
   // Get number of threads for OpenMP
   unsigned nt=OpenMP::getNumThreads();
   if( nt*stride*10>nactive_tasks ) nt=nactive_tasks/stride/10;
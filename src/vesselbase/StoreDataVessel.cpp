@@ -119,14 +119,23 @@ double StoreDataVessel::retrieveWeightWithIndex( const unsigned& myelem ) const
 }
 
 void StoreDataVessel::retrieveDerivatives( const unsigned& myelem, const bool& normed, MultiValue& myvals ) {
+  if( getAction()->lowmem ) {
+    plumed_dbg_assert( myvals.getNumberOfValues()==vecsize && myvals.getNumberOfDerivatives()==getAction()->getNumberOfDerivatives() );
+    myvals.clearAll(); recalculateStoredQuantity( myelem, myvals );
+    if( normed ) getAction()->normalizeVectorDerivatives( myvals );
+  } else {
+    retrieveSequentialDerivatives( getAction()->getPositionInCurrentTaskList( myelem ), normed, myvals );
+  }
+}
+
+void StoreDataVessel::retrieveSequentialDerivatives( const unsigned& jelem, const bool& normed, MultiValue& myvals ) {
   plumed_dbg_assert( myvals.getNumberOfValues()==vecsize && myvals.getNumberOfDerivatives()==getAction()->getNumberOfDerivatives() );
 
   myvals.clearAll();
   if( getAction()->lowmem ) {
-    recalculateStoredQuantity( myelem, myvals );
+    recalculateStoredQuantity( getTrueIndex( jelem ), myvals );
     if( normed ) getAction()->normalizeVectorDerivatives( myvals );
   } else {
-    unsigned jelem = getAction()->getPositionInCurrentTaskList( myelem );
     // Retrieve the derivatives for elements 0 and 1 - weight and norm
     for(unsigned icomp=0; icomp<vecsize; ++icomp) {
       unsigned ibuf = jelem * ( vecsize*nspace ) + icomp*nspace + 1;
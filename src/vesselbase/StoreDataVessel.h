@@ -103,6 +103,8 @@ public:
   double retrieveWeightWithIndex( const unsigned& myelem ) const ;
 /// Get the derivatives for one of the components in the vector
   void retrieveDerivatives( const unsigned& myelem, const bool& normed, MultiValue& myvals );
+/// Get the derivatives for the vector that is in position jelem of the list of stored values
+  void retrieveSequentialDerivatives( const unsigned& jelem, const bool& normed, MultiValue& myvals );
 /// Do all resizing of data
   virtual void resize();
 ///